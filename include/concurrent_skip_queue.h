@@ -0,0 +1,300 @@
+#ifndef CONCURRENT_SKIP_QUEUE_H
+#define CONCURRENT_SKIP_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+#include "skiplist.h"
+
+// 基于跳表的并发优先队列，节点布局与skiplist相同：[节点结构][forward数组]（不使用key缓存）
+// push和pop_min均无锁，多个线程可以同时调用
+// 链接的修改参照Herlihy和Shavit的无锁跳表：forward指针的最低位作为删除标记，
+// 节点的第0层后继被标记即表示节点已被某个线程取走（逻辑删除），之后由查找过程通过CAS将其从各层摘除（物理删除）
+// pop_min采用SprayList的松弛策略：从较低的高度开始随机地向前跳跃并逐层下降，落在前O(p log p)个元素中的某一个
+// 使多个线程取走不同的节点，避免所有线程竞争同一个最小元素，p为并发线程数，p为1时退化为精确的pop_min
+// 被摘除的节点可能仍被其他线程访问，因此不立即释放，而是在析构或调用reclaim时统一释放
+template <typename T, typename Compare = std::less<T>>
+class concurrent_skip_queue {
+	public:
+		typedef T value_type;
+		typedef size_t size_type;
+
+	private:
+		typedef __skiplist_node<T> skiplist_node;
+		typedef skiplist_node* link_type;
+
+		// 层数上限最多为63，与skiplist相同
+		static const size_type level_capacity = 64;
+		// 待释放节点的分片数，各线程随机选择一个分片，以减少对互斥锁的竞争
+		static const size_type retire_shards = 16;
+
+		// 待释放的节点
+		struct retire_list {
+			std::mutex mtx;
+			std::vector<link_type> nodes;
+		};
+
+		size_type max_level;
+		Compare key_compare;
+		link_type header;
+		// 元素数量，并发修改时只是近似值
+		std::atomic<size_type> node_count;
+		// SprayList的参数：起始高度和每层最多跳跃的步数
+		size_type spray_height;
+		size_type spray_jump;
+		retire_list retired[retire_shards];
+
+		// forward指针的删除标记
+		static bool marked(link_type x) { return reinterpret_cast<uintptr_t>(x) & 1; }
+		static link_type mark(link_type x) { return reinterpret_cast<link_type>(reinterpret_cast<uintptr_t>(x) | 1); }
+		static link_type unmark(link_type x) { return reinterpret_cast<link_type>(reinterpret_cast<uintptr_t>(x) & ~uintptr_t(1)); }
+
+		// 原子地读取和修改forward数组中的指针
+		static link_type load(link_type *slot) { return __atomic_load_n(slot, __ATOMIC_ACQUIRE); }
+		static bool cas(link_type *slot, link_type expected, link_type desired) {
+			return __atomic_compare_exchange_n(slot, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+		}
+
+		// 每个线程独立的随机数，使用xorshift生成
+		static size_type random() {
+			static thread_local size_type state = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			return state;
+		}
+		// 生成随机数作为节点层级，每次层级向上增长的概率为50%
+		size_type random_level() {
+			size_type level = 0;
+			for (size_type bits = random(); (bits & 1) && level < max_level; bits >>= 1) ++level;
+			return level;
+		}
+
+		// 创建和销毁节点
+		link_type create_node(const value_type &val, size_type level);
+		static void destroy_node(link_type node) {
+			node->~skiplist_node();
+			::operator delete(node);
+		}
+
+		// 查找每层中最后一个key不大于val的节点及其后继，保存到preds和succs中
+		// 沿途遇到已被标记的节点时将其从该层摘除，CAS失败则从头重新查找
+		// key相同的元素按插入的顺序排列，因此优先级相同的元素先进先出
+		void __find(const value_type &val, link_type *preds, link_type *succs);
+		// 尝试取走节点，从最高层开始标记节点的各层后继，成功标记第0层的线程取得该节点
+		bool __claim(link_type x);
+		// 第0层中第一个未被标记的节点
+		link_type __first() const;
+		// 随机跳跃，返回前O(p log p)个节点中的某一个
+		link_type __spray() const;
+		// 将所有被标记的节点从各层摘除，只能在没有并发操作时调用
+		void __unlink_marked();
+
+	public:
+		// 构造函数，threads为预期的并发线程数，为0时使用硬件支持的并发线程数
+		explicit concurrent_skip_queue(size_type threads = 0, size_type max_level = 18, const Compare &comp = Compare());
+		concurrent_skip_queue(const concurrent_skip_queue&) = delete;
+		concurrent_skip_queue& operator=(const concurrent_skip_queue&) = delete;
+		~concurrent_skip_queue();
+
+		// 插入元素，可以与其他push和pop_min并发调用
+		void push(const value_type &val);
+		// 取出一个较小的元素，队列为空时返回false
+		// 并发线程数大于1时，取出的元素在最小的前O(p log p)个元素之中
+		bool pop_min(value_type &val);
+
+		// 队列的元素数量，并发修改时只是近似值
+		size_type size() const { return node_count.load(std::memory_order_relaxed); }
+		bool empty() const { return __first() == nullptr; }
+
+		// 释放已被取出的节点，调用者需保证此时没有其他线程正在访问队列
+		void reclaim();
+};
+
+// 构造函数，创建层数为max_level的header，并根据并发线程数计算SprayList的参数
+template <typename T, typename Compare>
+concurrent_skip_queue<T, Compare>::concurrent_skip_queue(size_type threads, size_type max_level, const Compare &comp)
+	: max_level(max_level < 1 ? 1 : (max_level < level_capacity ? max_level : level_capacity-1)),
+	  key_compare(comp), header(nullptr), node_count(0) {
+	size_type p = skiplist_parallel(threads).concurrency();
+	// 起始高度和跳跃步数均约为log2(p)+1，p为1时不跳跃
+	size_type log_p = 0;
+	while ((size_type(1) << (log_p + 1)) <= p) ++log_p;
+	spray_height = p > 1 ? log_p + 1 : 0;
+	spray_jump = p > 1 ? log_p + 1 : 0;
+	header = create_node(value_type(), this->max_level);
+}
+
+// 析构函数，先摘除被标记的节点，再释放第0层的所有节点和待释放的节点
+template <typename T, typename Compare>
+concurrent_skip_queue<T, Compare>::~concurrent_skip_queue() {
+	reclaim();
+	link_type node = header->forward()[0];
+	while (node) {
+		link_type next = node->forward()[0];
+		destroy_node(node);
+		node = next;
+	}
+	destroy_node(header);
+}
+
+// 创建一个节点，forward数组紧跟在节点结构之后
+template <typename T, typename Compare>
+typename concurrent_skip_queue<T, Compare>::link_type
+concurrent_skip_queue<T, Compare>::create_node(const value_type &val, size_type level) {
+	char *p = static_cast<char*>(::operator new(sizeof(skiplist_node) + sizeof(link_type)*(level+1)));
+	try {
+		return new (p) skiplist_node(val, level, level+1, reinterpret_cast<link_type*>(p + sizeof(skiplist_node)));
+	} catch (...) {
+		::operator delete(p);
+		throw;
+	}
+}
+
+template <typename T, typename Compare>
+void concurrent_skip_queue<T, Compare>::__find(const value_type &val, link_type *preds, link_type *succs) {
+retry:
+	link_type pred = header;
+	for (int i = max_level; i >= 0; --i) {
+		link_type curr = unmark(load(&pred->forward()[i]));
+		while (curr) {
+			link_type succ = load(&curr->forward()[i]);
+			// curr在第i层已被标记，将其摘除，pred也被标记时CAS失败，需从头查找
+			if (marked(succ)) {
+				if (!cas(&pred->forward()[i], curr, unmark(succ))) goto retry;
+				curr = unmark(succ);
+				continue;
+			}
+			if (key_compare(val, curr->value_field)) break;
+			pred = curr;
+			curr = succ;
+		}
+		preds[i] = pred;
+		succs[i] = curr;
+	}
+}
+
+// 插入元素，先链接第0层（插入在此时生效），再自底向上链接其余各层
+// 链接上层时若CAS失败则重新查找前驱，若节点已被其他线程取走（后继被标记）则停止链接
+template <typename T, typename Compare>
+void concurrent_skip_queue<T, Compare>::push(const value_type &val) {
+	link_type preds[level_capacity], succs[level_capacity];
+	size_type level = random_level();
+	link_type node = create_node(val, level);
+	node_count.fetch_add(1, std::memory_order_relaxed);
+
+	while (true) {
+		__find(val, preds, succs);
+		for (size_type i = 0; i <= level; ++i) __atomic_store_n(&node->forward()[i], succs[i], __ATOMIC_RELAXED);
+		if (cas(&preds[0]->forward()[0], succs[0], node)) break;
+	}
+
+	for (size_type i = 1; i <= level; ++i) {
+		while (true) {
+			link_type old = load(&node->forward()[i]);
+			if (marked(old)) return;
+			if (old != succs[i] && !cas(&node->forward()[i], old, succs[i])) return;
+			if (cas(&preds[i]->forward()[i], succs[i], node)) break;
+			__find(val, preds, succs);
+		}
+	}
+}
+
+template <typename T, typename Compare>
+bool concurrent_skip_queue<T, Compare>::__claim(link_type x) {
+	for (size_type i = x->level; i >= 1; --i) {
+		link_type succ = load(&x->forward()[i]);
+		while (!marked(succ)) {
+			cas(&x->forward()[i], succ, mark(succ));
+			succ = load(&x->forward()[i]);
+		}
+	}
+	link_type succ = load(&x->forward()[0]);
+	while (!marked(succ)) {
+		if (cas(&x->forward()[0], succ, mark(succ))) return true;
+		succ = load(&x->forward()[0]);
+	}
+	return false;
+}
+
+template <typename T, typename Compare>
+typename concurrent_skip_queue<T, Compare>::link_type
+concurrent_skip_queue<T, Compare>::__first() const {
+	link_type x = unmark(load(&header->forward()[0]));
+	while (x && marked(load(&x->forward()[0]))) x = unmark(load(&x->forward()[0]));
+	return x;
+}
+
+// 从spray_height层开始，每层向前跳跃[0, spray_jump]个未被取走的节点后下降一层
+// 第i层的每一步约跨过2^i个元素，因此落点约在前spray_jump * 2^spray_height = O(p log p)个元素中
+template <typename T, typename Compare>
+typename concurrent_skip_queue<T, Compare>::link_type
+concurrent_skip_queue<T, Compare>::__spray() const {
+	link_type x = header;
+	for (int i = spray_height < max_level ? spray_height : max_level; i >= 0; --i) {
+		size_type steps = random() % (spray_jump + 1);
+		while (steps) {
+			link_type next = unmark(load(&x->forward()[i]));
+			if (!next) break;
+			x = next;
+			if (!marked(load(&x->forward()[0]))) --steps;
+		}
+	}
+	// 未前进或落在已被取走的节点上时，取其后第一个未被取走的节点
+	if (x == header) return __first();
+	while (x && marked(load(&x->forward()[0]))) x = unmark(load(&x->forward()[0]));
+	return x;
+}
+
+// 取出一个较小的元素，先尝试若干次随机跳跃，失败过多时退化为从头查找第一个未被取走的节点
+// 取得节点后通过__find将其从各层摘除，再放入待释放的列表中
+template <typename T, typename Compare>
+bool concurrent_skip_queue<T, Compare>::pop_min(value_type &val) {
+	link_type preds[level_capacity], succs[level_capacity];
+	for (size_type attempt = 0; ; ++attempt) {
+		link_type x = attempt < 4 ? __spray() : __first();
+		if (!x) {
+			if (__first()) continue;
+			return false;
+		}
+		if (!__claim(x)) continue;
+
+		val = x->value_field;
+		node_count.fetch_sub(1, std::memory_order_relaxed);
+		__find(val, preds, succs);
+		retire_list &list = retired[random() % retire_shards];
+		std::lock_guard<std::mutex> lock(list.mtx);
+		list.nodes.push_back(x);
+		return true;
+	}
+}
+
+// 将所有被标记的节点从各层摘除
+// 插入线程可能在节点被取走并摘除后，才将其链接到上层，因此释放之前需要再检查一遍各层
+template <typename T, typename Compare>
+void concurrent_skip_queue<T, Compare>::__unlink_marked() {
+	for (size_type i = 0; i <= max_level; ++i) {
+		link_type pred = header;
+		while (link_type curr = unmark(pred->forward()[i])) {
+			if (marked(curr->forward()[i])) pred->forward()[i] = unmark(curr->forward()[i]);
+			else pred = curr;
+		}
+	}
+}
+
+// 释放已被取出的节点，调用者需保证此时没有其他线程正在访问队列
+template <typename T, typename Compare>
+void concurrent_skip_queue<T, Compare>::reclaim() {
+	__unlink_marked();
+	for (size_type i = 0; i < retire_shards; ++i) {
+		for (link_type node : retired[i].nodes) destroy_node(node);
+		retired[i].nodes.clear();
+	}
+}
+
+#endif
@@ -0,0 +1,441 @@
+#ifndef SKIP_AGGREGATE_MAP_H
+#define SKIP_AGGREGATE_MAP_H
+
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "skiplist.h"
+
+// skip_aggregate_map使用的幺半群：result_type为聚合值的类型，identity()为单位元
+// lift(实值)将一个元素的实值转换为聚合值，operator()(a, b)按key的顺序合并两个聚合值，要求满足结合律（不要求交换律）
+template <typename T>
+struct skiplist_sum {
+	typedef T result_type;
+	result_type identity() const { return T(); }
+	result_type lift(const T &x) const { return x; }
+	result_type operator()(const result_type &a, const result_type &b) const { return a + b; }
+};
+template <typename T>
+struct skiplist_min {
+	typedef T result_type;
+	result_type identity() const { return std::numeric_limits<T>::max(); }
+	result_type lift(const T &x) const { return x; }
+	result_type operator()(const result_type &a, const result_type &b) const { return b < a ? b : a; }
+};
+template <typename T>
+struct skiplist_max {
+	typedef T result_type;
+	result_type identity() const { return std::numeric_limits<T>::lowest(); }
+	result_type lift(const T &x) const { return x; }
+	result_type operator()(const result_type &a, const result_type &b) const { return a < b ? b : a; }
+};
+
+// 维护区间聚合值的skip_map，aggregate(lo, hi)以O(log n)的期望时间返回key在[lo, hi)范围内所有元素的聚合值，与范围的大小无关
+// 节点x在第i层的聚合值为x之后、直到x在第i层的后继（含）为止所有元素的聚合值，后继为空时直到最后一个元素
+// 第0层的聚合值即为后继的实值，第i层的聚合值由第i-1层中位于该区间内的各段合并得到，期望只需合并常数段
+// 插入、删除和修改实值时沿查找路径自底向上重新计算各层前驱（插入时还有新节点）的聚合值，期望时间复杂度为O(log n)
+// 实值只能通过insert_or_assign和modify修改，迭代器只提供常量访问
+// 节点布局为[节点结构][forward数组][聚合值数组]，聚合值数组的大小与forward数组相同
+// MaxLevel与Policy的含义与skiplist相同，节点层级的生成和层数上限的增长也与skiplist相同
+// 聚合值依附于随机层级的各段，因此只支持随机平衡，且不支持改变节点布局的哈希索引、后继key缓存、紧凑链接和单写多读模式
+template <typename Key, typename T, typename Monoid = skiplist_sum<T>, typename Compare = std::less<Key>,
+		size_t MaxLevel = 0, typename Policy = skiplist_default_policy>
+class skip_aggregate_map {
+	public:
+		typedef Key key_type;
+		typedef T data_type;
+		typedef T mapped_type;
+		typedef std::pair<const Key, T> value_type;
+		typedef Monoid monoid_type;
+		typedef typename Monoid::result_type result_type;
+		typedef size_t size_type;
+		typedef ptrdiff_t difference_type;
+		// 策略指定的观察者
+		typedef typename Policy::observer observer_type;
+
+		// 默认的层数上限，若指定了编译期层数上限则使用MaxLevel
+		static const size_type default_max_level = __skiplist_levels<MaxLevel>::default_max_level;
+
+	private:
+		static_assert(Policy::balance == skiplist_random_balance, "skip_aggregate_map requires random balance");
+		static_assert(!Policy::hash_index && !Policy::cached_links && !Policy::compact_links && !Policy::concurrent_readers,
+				"skip_aggregate_map does not support policies that change the node layout");
+		typedef __skiplist_node<value_type> skiplist_node;
+		typedef skiplist_node* link_type;
+
+		// 查找时保存前驱节点的update数组的容量，与skiplist相同
+		static const size_type update_capacity = __skiplist_levels<MaxLevel>::capacity;
+		// 聚合值数组在节点中的偏移，按result_type的对齐要求向上对齐
+		static size_type aggregate_offset(size_type capacity) {
+			size_type offset = sizeof(skiplist_node) + sizeof(link_type)*capacity;
+			return (offset + alignof(result_type) - 1) / alignof(result_type) * alignof(result_type);
+		}
+		static result_type* link_aggregates(link_type x) {
+			return reinterpret_cast<result_type*>(reinterpret_cast<char*>(x) + aggregate_offset(x->capacity));
+		}
+		static const key_type& key(link_type x) { return x->value_field.first; }
+
+		size_type max_level;
+		size_type top_level;
+		size_type node_count;
+		Compare key_compare;
+		Monoid monoid;
+		link_type header;
+		// 统计信息不随复制、移动和交换转移
+		mutable observer_type observer;
+
+		// 生成随机数作为节点层级
+		size_type random_level() const { return __skiplist_levels<MaxLevel>::random(max_level); }
+		// 获取头节点的层数，编译期指定了MaxLevel时为常量
+		size_type level_limit() const { return MaxLevel ? MaxLevel : max_level; }
+		// 将运行期的层数上限提高到level，重新分配header并复制各层的链接和聚合值，编译期指定了MaxLevel时不做任何事
+		void __raise_level(size_type level);
+		// 节点数量超过2^max_level时提高层数上限，与skiplist相同
+		void __grow() { __raise_level(__skiplist_levels<MaxLevel>::reserve(node_count, max_level)); }
+		// 创建和销毁节点，聚合值均初始化为单位元
+		template <typename V>
+		link_type create_node(V &&val, size_type level);
+		static void destroy_node(link_type node) {
+			result_type *agg = link_aggregates(node);
+			for (size_type i = 0; i < node->capacity; ++i) agg[i].~result_type();
+			node->~skiplist_node();
+			::operator delete(node);
+		}
+
+		// 返回第0层中第一个key不小于k的节点，并将每层的前驱节点保存到update中
+		// trace为观察者的追踪对象，被采样时记录在每层前进的步数
+		template <typename Trace>
+		link_type __search(const key_type &k, link_type *update, Trace &trace) const;
+		link_type __search(const key_type &k, link_type *update) const {
+			__skiplist_no_trace trace;
+			return __search(k, update, trace);
+		}
+		// 重新计算节点x在第i层的聚合值，要求x在第i-1层之后的各段均已是最新的
+		void __recompute(link_type x, size_type i);
+		// 自底向上重新计算update中各层前驱的聚合值，node不为空时一并计算新插入节点在其各层的聚合值
+		void __repair(link_type *update, link_type node);
+		// 按update中的前驱插入一个新节点，返回新节点；插入后由调用者在不再使用update时调用__grow
+		template <typename V>
+		link_type __insert(link_type *update, V &&val);
+		// 从第0层开始按key的顺序逐层计算所有节点的聚合值
+		void __rebuild();
+		// 按key的顺序复制rhs的所有元素，要求当前容器为空
+		void __copy(const skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy> &rhs);
+
+	public:
+		typedef __skiplist_iterator<value_type, const value_type&, const value_type*, skiplist_node> iterator;
+		typedef iterator const_iterator;
+
+		explicit skip_aggregate_map(size_type max_level = default_max_level, const Compare &comp = Compare(), const Monoid &m = Monoid());
+		template <typename InputIterator>
+		skip_aggregate_map(InputIterator first, InputIterator last) : skip_aggregate_map() { insert(first, last); }
+		skip_aggregate_map(const skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy> &rhs)
+			: skip_aggregate_map(rhs.max_level, rhs.key_compare, rhs.monoid) { __copy(rhs); }
+		skip_aggregate_map(skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy> &&rhs) : skip_aggregate_map(rhs.max_level, rhs.key_compare, rhs.monoid) {
+			swap(rhs);
+		}
+		skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>& operator=(const skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy> &rhs) {
+			skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy> tmp(rhs);
+			swap(tmp);
+			return *this;
+		}
+		skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>& operator=(skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy> &&rhs) {
+			swap(rhs);
+			return *this;
+		}
+		~skip_aggregate_map() {
+			clear();
+			destroy_node(header);
+		}
+		void swap(skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy> &rhs) {
+			std::swap(max_level, rhs.max_level);
+			std::swap(top_level, rhs.top_level);
+			std::swap(node_count, rhs.node_count);
+			std::swap(key_compare, rhs.key_compare);
+			std::swap(monoid, rhs.monoid);
+			std::swap(header, rhs.header);
+		}
+
+		Compare key_comp() const { return key_compare; }
+		monoid_type get_monoid() const { return monoid; }
+		observer_type& get_observer() const { return observer; }
+		iterator begin() const { return header->forward()[0]; }
+		iterator end() const { return iterator(); }
+		bool empty() const { return node_count == 0; }
+		size_type size() const { return node_count; }
+
+		// 查找操作
+		iterator find(const key_type &k) const {
+			typename observer_type::trace trace(observer, skiplist_op_find);
+			link_type update[update_capacity];
+			link_type x = __search(k, update, trace);
+			return x && !key_compare(k, key(x)) ? x : nullptr;
+		}
+		iterator lower_bound(const key_type &k) const {
+			link_type update[update_capacity];
+			return __search(k, update);
+		}
+		size_type count(const key_type &k) const { return find(k) != end(); }
+
+		// 插入操作，key已存在时不修改实值并返回该元素的迭代器和false
+		std::pair<iterator, bool> insert(const value_type &val) {
+			typename observer_type::trace trace(observer, skiplist_op_insert);
+			link_type update[update_capacity];
+			link_type x = __search(val.first, update, trace);
+			if (x && !key_compare(val.first, key(x))) return std::pair<iterator, bool>(x, false);
+			x = __insert(update, val);
+			__grow();
+			return std::pair<iterator, bool>(x, true);
+		}
+		template <typename InputIterator>
+		void insert(InputIterator first, InputIterator last) {
+			for (; first != last; ++first) insert(*first);
+		}
+		// 插入或覆盖，key已存在时修改其实值并重新计算前驱的聚合值
+		template <typename V>
+		std::pair<iterator, bool> insert_or_assign(const key_type &k, V &&value) {
+			typename observer_type::trace trace(observer, skiplist_op_insert);
+			link_type update[update_capacity];
+			link_type x = __search(k, update, trace);
+			if (!x || key_compare(k, key(x))) {
+				x = __insert(update, value_type(k, std::forward<V>(value)));
+				__grow();
+				return std::pair<iterator, bool>(x, true);
+			}
+			x->value_field.second = std::forward<V>(value);
+			__repair(update, nullptr);
+			return std::pair<iterator, bool>(x, false);
+		}
+		// 对key为k的元素的实值调用fn(T&)，key不存在时先插入T的默认值，完成后重新计算前驱的聚合值
+		template <typename Function>
+		void modify(const key_type &k, Function fn);
+
+		// 删除操作，返回删除的元素数
+		size_type erase(const key_type &k);
+		void clear();
+
+		// key在[lo, hi)范围内所有元素的聚合值，范围为空时返回单位元
+		result_type aggregate(const key_type &lo, const key_type &hi) const;
+		// 所有元素的聚合值
+		result_type aggregate() const;
+};
+
+// 构造函数，创建层数为max_level的header
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::skip_aggregate_map(size_type max_level, const Compare &comp, const Monoid &m)
+	: max_level(__skiplist_levels<MaxLevel>::clamp(max_level)),
+	  top_level(0), node_count(0), key_compare(comp), monoid(m), header(nullptr) {
+	header = create_node(value_type(), level_limit());
+}
+
+// header的聚合值数组紧跟在forward数组之后，无法原地扩展，因此分配新的header后复制[0, top_level]各层
+// 旧的header可能仍保存在update中，因此只在插入和重新计算聚合值都完成后调用
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+void skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::__raise_level(size_type level) {
+	if (MaxLevel || level <= max_level) return;
+	link_type x = create_node(value_type(), level);
+	for (size_type i = 0; i <= top_level; ++i) {
+		x->forward()[i] = header->forward()[i];
+		link_aggregates(x)[i] = link_aggregates(header)[i];
+	}
+	destroy_node(header);
+	header = x;
+	max_level = level;
+}
+
+// 创建一个节点，forward数组紧跟在节点结构之后，聚合值数组位于forward数组之后
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+template <typename V>
+typename skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::link_type
+skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::create_node(V &&val, size_type level) {
+	size_type offset = aggregate_offset(level + 1);
+	char *p = static_cast<char*>(::operator new(offset + sizeof(result_type)*(level+1)));
+	result_type *agg = reinterpret_cast<result_type*>(p + offset);
+	size_type constructed = 0;
+	try {
+		for (; constructed <= level; ++constructed) new (agg + constructed) result_type(monoid.identity());
+		return new (p) skiplist_node(std::forward<V>(val), level, level+1, reinterpret_cast<link_type*>(p + sizeof(skiplist_node)));
+	} catch (...) {
+		while (constructed) agg[--constructed].~result_type();
+		::operator delete(p);
+		throw;
+	}
+}
+
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+template <typename Trace>
+typename skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::link_type
+skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::__search(const key_type &k, link_type *update, Trace &trace) const {
+	// 未被采样的操作使用不记录信息的查找
+	if (!std::is_same<Trace, __skiplist_no_trace>::value && !trace.active()) return __search(k, update);
+	link_type current = header;
+	for (int i = top_level; i >= 0; --i) {
+		size_type hops = 0;
+		link_type next;
+		while ((next = current->forward()[i]) && key_compare(key(next), k)) { current = next; ++hops; }
+		trace.hops(i, hops);
+		update[i] = current;
+	}
+	return current->forward()[0];
+}
+
+// x在第i层的区间(x, 后继]由第i-1层中x及区间内各节点的区间依次拼接而成
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+void skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::__recompute(link_type x, size_type i) {
+	if (i == 0) {
+		link_type next = x->forward()[0];
+		link_aggregates(x)[0] = next ? monoid.lift(next->value_field.second) : monoid.identity();
+		return;
+	}
+	link_type stop = x->forward()[i];
+	result_type acc = link_aggregates(x)[i-1];
+	for (link_type y = x->forward()[i-1]; y != stop; y = y->forward()[i-1]) acc = monoid(acc, link_aggregates(y)[i-1]);
+	link_aggregates(x)[i] = acc;
+}
+
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+void skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::__repair(link_type *update, link_type node) {
+	for (size_type i = 0; i <= top_level; ++i) {
+		if (node && i <= node->level) __recompute(node, i);
+		__recompute(update[i], i);
+	}
+}
+
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+template <typename V>
+typename skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::link_type
+skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::__insert(link_type *update, V &&val) {
+	size_type level = random_level();
+	link_type node = create_node(std::forward<V>(val), level);
+	// 新节点的层级高于当前最高层时，新增各层的前驱为header
+	for (; top_level < level; ++top_level) update[top_level + 1] = header;
+	for (size_type i = 0; i <= level; ++i) {
+		node->forward()[i] = update[i]->forward()[i];
+		update[i]->forward()[i] = node;
+	}
+	++node_count;
+	__repair(update, node);
+	return node;
+}
+
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+template <typename Function>
+void skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::modify(const key_type &k, Function fn) {
+	typename observer_type::trace trace(observer, skiplist_op_insert);
+	link_type update[update_capacity];
+	link_type x = __search(k, update, trace);
+	if (!x || key_compare(k, key(x))) x = __insert(update, value_type(k, T()));
+	// fn抛出异常时实值可能已被部分修改，仍需重新计算聚合值
+	try {
+		fn(x->value_field.second);
+	} catch (...) {
+		__repair(update, nullptr);
+		__grow();
+		throw;
+	}
+	__repair(update, nullptr);
+	__grow();
+}
+
+// 摘除节点后先降低最高层，再重新计算剩余各层前驱的聚合值
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+typename skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::size_type
+skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::erase(const key_type &k) {
+	typename observer_type::trace trace(observer, skiplist_op_erase);
+	link_type update[update_capacity];
+	link_type x = __search(k, update, trace);
+	if (!x || key_compare(k, key(x))) return 0;
+	for (size_type i = 0; i <= x->level; ++i) update[i]->forward()[i] = x->forward()[i];
+	destroy_node(x);
+	--node_count;
+	while (top_level > 0 && !header->forward()[top_level]) {
+		link_aggregates(header)[top_level] = monoid.identity();
+		--top_level;
+	}
+	__repair(update, nullptr);
+	return 1;
+}
+
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+void skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::clear() {
+	link_type x = header->forward()[0];
+	while (x) {
+		link_type next = x->forward()[0];
+		destroy_node(x);
+		x = next;
+	}
+	for (size_type i = 0; i <= top_level; ++i) {
+		header->forward()[i] = nullptr;
+		link_aggregates(header)[i] = monoid.identity();
+	}
+	top_level = 0;
+	node_count = 0;
+}
+
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+void skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::__rebuild() {
+	for (size_type i = 0; i <= top_level; ++i)
+		for (link_type x = header; x; x = x->forward()[i]) __recompute(x, i);
+}
+
+// 按key的顺序将元素追加到各层的末尾，链接完成后逐层计算聚合值，总时间复杂度为O(n)
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+void skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::__copy(const skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy> &rhs) {
+	link_type tail[update_capacity];
+	for (size_type i = 0; i <= max_level; ++i) tail[i] = header;
+	try {
+		for (link_type x = rhs.header->forward()[0]; x; x = x->forward()[0]) {
+			link_type node = create_node(x->value_field, x->level);
+			if (node->level > top_level) top_level = node->level;
+			for (size_type i = 0; i <= node->level; ++i) {
+				tail[i]->forward()[i] = node;
+				tail[i] = node;
+			}
+			++node_count;
+		}
+	} catch (...) {
+		clear();
+		throw;
+	}
+	__rebuild();
+}
+
+// 先找到第0层中最后一个key小于lo的节点，再从该节点出发：
+// 上升阶段在当前节点的最高层前进，只要后继的key小于hi就合并该段并前进到后继，后继的层级不低于当前层，因此只会上升
+// 后继不小于hi时进入下降阶段，逐层向下，在每层中合并key小于hi的各段；两个阶段的期望步数均为O(log n)
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+typename skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::result_type
+skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::aggregate(const key_type &lo, const key_type &hi) const {
+	result_type acc = monoid.identity();
+	if (!key_compare(lo, hi)) return acc;
+	link_type update[update_capacity];
+	__search(lo, update);
+	link_type x = update[0];
+	size_type i = x == header ? top_level : x->level;
+	link_type next;
+	while ((next = x->forward()[i]) && key_compare(key(next), hi)) {
+		acc = monoid(acc, link_aggregates(x)[i]);
+		x = next;
+		i = x->level;
+	}
+	while (i-- > 0) {
+		while ((next = x->forward()[i]) && key_compare(key(next), hi)) {
+			acc = monoid(acc, link_aggregates(x)[i]);
+			x = next;
+		}
+	}
+	return acc;
+}
+
+template <typename Key, typename T, typename Monoid, typename Compare, size_t MaxLevel, typename Policy>
+typename skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::result_type
+skip_aggregate_map<Key, T, Monoid, Compare, MaxLevel, Policy>::aggregate() const {
+	result_type acc = monoid.identity();
+	for (link_type x = header; x; x = x->forward()[top_level]) acc = monoid(acc, link_aggregates(x)[top_level]);
+	return acc;
+}
+
+#endif
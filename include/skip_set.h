@@ -5,17 +5,17 @@
 #include "skiplist.h"
 
 // 前置声明，在skip_set中声明友元需要
-template <typename Key, typename Compare>
+template <typename Key, typename Compare, size_t MaxLevel, typename Policy>
 class skip_set;
 
-template <typename Key, typename Compare>
-bool operator==(const skip_set<Key, Compare> &lhs, const skip_set<Key, Compare> &rhs);
+template <typename Key, typename Compare, size_t MaxLevel, typename Policy>
+bool operator==(const skip_set<Key, Compare, MaxLevel, Policy> &lhs, const skip_set<Key, Compare, MaxLevel, Policy> &rhs);
 
-// template <typename Key, typename Compare>
-// bool operator<(const skip_set<Key, Compare> &lhs, const skip_set<Key, Compare> &rhs);
+// template <typename Key, typename Compare, size_t MaxLevel, typename Policy>
+// bool operator<(const skip_set<Key, Compare, MaxLevel, Policy> &lhs, const skip_set<Key, Compare, MaxLevel, Policy> &rhs);
 
 // skip_set类
-template <typename Key, typename Compare = std::less<Key>>
+template <typename Key, typename Compare = std::less<Key>, size_t MaxLevel = 0, typename Policy = skiplist_default_policy>
 class skip_set {
 	public:
 		// set的key就是value
@@ -28,11 +28,13 @@ class skip_set {
 		// 证同函数，任何数值通过此函数后，不会有任何改变
 		// 作为跳表的KeyOfValue使用，因为set的value就是key
 		template <typename T>
-		struct identity : public std::unary_function<T, T> {
+		struct identity {
+			typedef T argument_type;
+			typedef T result_type;
 			const T& operator()(const T& x) const { return x; }
 		};
 		// 使用跳表作为set的底层容器
-		typedef skiplist<key_type, value_type, identity<value_type>, key_compare> rep_type;
+		typedef skiplist<key_type, value_type, identity<value_type>, key_compare, MaxLevel, Policy> rep_type;
 		rep_type rep;
 
 	public:
@@ -46,37 +48,53 @@ class skip_set {
 		typedef typename rep_type::const_iterator const_iterator;
 		typedef typename rep_type::size_type size_type;
 		typedef typename rep_type::difference_type difference_type;
-
-		// 构造函数，默认的层数上限为18
-		skip_set() : rep(18, Compare()) {}
+		// 节点句柄，以及插入节点句柄的返回值
+		typedef typename rep_type::node_type node_type;
+		typedef __skiplist_insert_return<iterator, node_type> insert_return_type;
+		typedef typename rep_type::observer_type observer_type;
+		typedef typename rep_type::cursor cursor;
+
+		// 构造函数，默认的初始层数上限为18，之后随元素数量自动提高；若指定了编译期层数上限MaxLevel则固定为MaxLevel
+		skip_set() : rep(rep_type::default_max_level, Compare()) {}
 		explicit skip_set(size_type max_level) : rep(max_level, Compare()) {}
-		explicit skip_set(const Compare &comp) : rep(18, comp) {}
+		explicit skip_set(const Compare &comp) : rep(rep_type::default_max_level, comp) {}
 		skip_set(size_type max_level, const Compare &comp) : rep(max_level, comp) {}
 
 		// 允许从一对迭代器[first, last)指示的范围来构造skip_set
 		template <typename InputIterator>
 		skip_set(InputIterator first, InputIterator last)
-			: rep(18, Compare()) { rep.insert_unique(first, last); }
+			: rep(rep_type::default_max_level, Compare()) { rep.insert_unique(first, last); }
 		template <typename InputIterator>
 		skip_set(InputIterator first, InputIterator last, size_type max_level)
 			: rep(max_level, Compare()) { rep.insert_unique(first, last); }
 		template <typename InputIterator>
 		skip_set(InputIterator first, InputIterator last, const Compare &comp)
-			: rep(18, comp) { rep.insert_unique(first, last); }
+			: rep(rep_type::default_max_level, comp) { rep.insert_unique(first, last); }
 		template <typename InputIterator>
 		skip_set(InputIterator first, InputIterator last, size_type max_level, const Compare &comp)
 			: rep(max_level, comp) { rep.insert_unique(first, last); }
+		// 使用多个线程从一对迭代器[first, last)指示的无序范围来构造skip_set
+		template <typename InputIterator>
+		skip_set(InputIterator first, InputIterator last, const skiplist_parallel &policy)
+			: rep(rep_type::default_max_level, Compare()) { rep.insert_unique(first, last, policy); }
+		template <typename InputIterator>
+		skip_set(InputIterator first, InputIterator last, size_type max_level, const Compare &comp, const skiplist_parallel &policy)
+			: rep(max_level, comp) { rep.insert_unique(first, last, policy); }
 
 		// 拷贝构造
-		skip_set(const skip_set<Key, Compare> &rhs) : rep(rhs.rep) {}
+		skip_set(const skip_set<Key, Compare, MaxLevel, Policy> &rhs) : rep(rhs.rep) {}
+		// 移动构造，不分配内存，rhs被移动后成为空容器，仍可正常使用
+		skip_set(skip_set<Key, Compare, MaxLevel, Policy> &&rhs) noexcept(std::is_nothrow_move_constructible<rep_type>::value) : rep(std::move(rhs.rep)) {}
 		// 赋值运算符
-		skip_set<Key, Compare>& operator=(const skip_set<Key, Compare> &rhs) { rep = rhs.rep; return *this; }
+		skip_set<Key, Compare, MaxLevel, Policy>& operator=(const skip_set<Key, Compare, MaxLevel, Policy> &rhs) { rep = rhs.rep; return *this; }
+		skip_set<Key, Compare, MaxLevel, Policy>& operator=(skip_set<Key, Compare, MaxLevel, Policy> &&rhs) noexcept(std::is_nothrow_move_assignable<rep_type>::value) { rep = std::move(rhs.rep); return *this; }
 		// 交换操作
-		void swap(skip_set<Key, Compare> &rhs) { rep.swap(rhs.rep); }
+		void swap(skip_set<Key, Compare, MaxLevel, Policy> &rhs) { rep.swap(rhs.rep); }
 
 		// 转调用跳表的接口
 		key_compare key_comp() const { return rep.key_comp(); }
 		value_compare value_comp() const { return rep.key_comp(); }
+		observer_type& get_observer() const { return rep.get_observer(); }
 		iterator begin() const { return rep.begin(); }
 		const_iterator cbegin() const { return rep.cbegin(); }
 		iterator end() const { return rep.end(); }
@@ -84,32 +102,116 @@ class skip_set {
 		bool empty() const { return rep.empty(); }
 		size_type size() const { return rep.size(); }
 		size_type max_size() const { return rep.max_size(); }
+		// 访问和删除key最小的元素，容器不能为空，删除的期望时间复杂度为O(1)
+		const_reference front() const { return rep.front(); }
+		void pop_front() { rep.pop_front(); }
 
 		// 插入操作
 		std::pair<iterator, bool> insert(const value_type &val) { return rep.insert_unique(val); }
+		// 插入节点句柄所拥有的节点，不重新分配节点
+		insert_return_type insert(node_type &&nh) {
+			typename rep_type::insert_return_type r = rep.insert_unique(std::move(nh));
+			return insert_return_type{r.position, r.inserted, std::move(r.node)};
+		}
 
 		template <typename InputIterator>
 		void insert(InputIterator first, InputIterator last) { rep.insert_unique(first, last); }
+		template <typename InputIterator>
+		void insert(InputIterator first, InputIterator last, const skiplist_parallel &policy) { rep.insert_unique(first, last, policy); }
 
 		// 删除操作
 		void erase(const key_type &k) { rep.erase(k); }
 
 		void erase(iterator first, iterator last) { rep.erase(first, last); }
+		// 单写多读模式下销毁已删除的节点，须在没有读者访问时调用
+		void reclaim() { rep.reclaim(); }
+
+		// 摘除操作，返回拥有该元素节点的句柄，可用于在容器之间转移元素或修改元素的key
+		node_type extract(const key_type &k) { return rep.extract(k); }
+		node_type extract(const_iterator position) { return rep.extract(position); }
 
 		// 清空操作
 		void clear() { rep.clear(); }
 
+		// 增量整理，按key的顺序将元素重新分配到连续的内存中，每次最多移动steps个元素，整理到末尾时返回true
+		bool compact(size_type steps = size_type(-1)) { return rep.compact(steps); }
+
+		// 冻结为只读的紧凑表示，节点连续存放且没有各层的forward数组，查找使用按缓存行分块的静态B+树
+		// 冻结后的修改操作会先自动解冻；以已存在的key插入不会解冻；冻结和解冻使所有迭代器失效
+		void freeze() { rep.freeze(); }
+		void thaw() { rep.thaw(); }
+		bool frozen() const { return rep.frozen(); }
+
+		// 合并操作，将rhs中key不存在于当前容器的节点转移过来，不重新分配节点，时间复杂度为O(n+m)
+		void merge(skip_set<Key, Compare, MaxLevel, Policy> &rhs) { rep.merge(rhs.rep); }
+
+		// 拆分操作，将key大于等于k的元素转移到新容器中并返回，只切断查找路径上的链接
+		// 确定性平衡模式下需重新分配两侧所有节点的层级，时间复杂度为O(n)
+		skip_set<Key, Compare, MaxLevel, Policy> split(const key_type &k) {
+			skip_set<Key, Compare, MaxLevel, Policy> result(rep.get_max_level(), key_comp());
+			rep.split(k, result.rep);
+			return result;
+		}
+		// 连接操作，将rhs的所有元素转移到当前容器的末尾，要求rhs中的key均大于当前容器中的key
+		// 确定性平衡模式下需重新分配所有节点的层级，时间复杂度为O(n+m)
+		void join(skip_set<Key, Compare, MaxLevel, Policy> &rhs) { rep.join(rhs.rep); }
+
+		// 集合运算，以线性时间计算并返回两个set的并集、交集和差集
+		skip_set<Key, Compare, MaxLevel, Policy> set_union(const skip_set<Key, Compare, MaxLevel, Policy> &rhs) const {
+			skip_set<Key, Compare, MaxLevel, Policy> result(rep.get_max_level(), key_comp());
+			rep.set_union(rhs.rep, result.rep);
+			return result;
+		}
+		skip_set<Key, Compare, MaxLevel, Policy> set_intersection(const skip_set<Key, Compare, MaxLevel, Policy> &rhs) const {
+			skip_set<Key, Compare, MaxLevel, Policy> result(rep.get_max_level(), key_comp());
+			rep.set_intersection(rhs.rep, result.rep);
+			return result;
+		}
+		skip_set<Key, Compare, MaxLevel, Policy> set_difference(const skip_set<Key, Compare, MaxLevel, Policy> &rhs) const {
+			skip_set<Key, Compare, MaxLevel, Policy> result(rep.get_max_level(), key_comp());
+			rep.set_difference(rhs.rep, result.rep);
+			return result;
+		}
+
 		// 查找操作
+		// 自适应平衡模式下find会修改跳表，多个线程同时调用find时需要外部同步；lower_bound不修改跳表
 		iterator find(const key_type &k) const { return rep.find(k); }
+		iterator lower_bound(const key_type &k) const { return rep.lower_bound(k); }
+		// 批量查找，第i个key的查找结果写入result[i]，多个查找交替进行以重叠缓存缺失
+		template <typename ForwardIterator, typename RandomAccessIterator>
+		void find_many(ForwardIterator first, ForwardIterator last, RandomAccessIterator result) const {
+			rep.find_many(first, last, result);
+		}
+		// 只读游标，向递增的key反复定位时从上一次的位置继续查找
+		cursor get_cursor() const { return rep.get_cursor(); }
+
+		// 并行遍历key在[lo, hi)范围内的所有元素，fn会被多个线程同时调用
+		template <typename Function>
+		void parallel_for_each(const key_type &lo, const key_type &hi, Function fn,
+				const skiplist_parallel &policy = skiplist_parallel()) const {
+			rep.parallel_for_each(lo, hi, [&fn](const value_type &v) { fn(v); }, policy);
+		}
+		// 并行归约key在[lo, hi)范围内的所有元素，init应为op的单位元，op同时用于累积元素和合并各块的结果
+		template <typename U, typename BinaryOperation>
+		U parallel_reduce(const key_type &lo, const key_type &hi, U init, BinaryOperation op,
+				const skiplist_parallel &policy = skiplist_parallel()) const {
+			return rep.parallel_reduce(lo, hi, init, op, op, policy);
+		}
+		// 累积元素与合并结果使用不同的操作，例如累积元素的实值op(acc, value)，再以combine(acc, acc)合并
+		template <typename U, typename BinaryOperation, typename Combine>
+		U parallel_reduce(const key_type &lo, const key_type &hi, U init, BinaryOperation op, Combine combine,
+				const skiplist_parallel &policy = skiplist_parallel()) const {
+			return rep.parallel_reduce(lo, hi, init, op, combine, policy);
+		}
 
 		// 重载关系运算符的友元声明
-		friend bool operator==<Key, Compare>(const skip_set<Key, Compare> &lhs, const skip_set<Key, Compare> &rhs);
-		// friend bool operator< <Key, Compare>(const skip_set<Key, Compare> &lhs, const skip_set<Key, Compare> &rhs);
+		friend bool operator==<Key, Compare, MaxLevel, Policy>(const skip_set<Key, Compare, MaxLevel, Policy> &lhs, const skip_set<Key, Compare, MaxLevel, Policy> &rhs);
+		// friend bool operator< <Key, Compare, MaxLevel, Policy>(const skip_set<Key, Compare, MaxLevel, Policy> &lhs, const skip_set<Key, Compare, MaxLevel, Policy> &rhs);
 };
 
 // 定义重载的相等性判断运算符
-template <typename Key, typename Compare>
-inline bool operator==(const skip_set<Key, Compare> &lhs, const skip_set<Key, Compare> &rhs) {
+template <typename Key, typename Compare, size_t MaxLevel, typename Policy>
+inline bool operator==(const skip_set<Key, Compare, MaxLevel, Policy> &lhs, const skip_set<Key, Compare, MaxLevel, Policy> &rhs) {
 	return lhs.rep == rhs.rep;
 }
 
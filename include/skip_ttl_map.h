@@ -0,0 +1,224 @@
+#ifndef SKIP_TTL_MAP_H
+#define SKIP_TTL_MAP_H
+
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include "skip_map.h"
+#include "skip_set.h"
+
+// skip_ttl_map的迭代器，跳过在now时刻已过期的元素，解引用得到key和实值的引用组成的pair
+template <typename Key, typename T, typename IndexIterator, typename TimePoint>
+class __skip_ttl_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef std::pair<const Key, T> value_type;
+		typedef std::pair<const Key&, T&> reference;
+		typedef void pointer;
+		typedef ptrdiff_t difference_type;
+
+	private:
+		IndexIterator it;
+		IndexIterator last;
+		TimePoint now;
+
+		void skip_expired() { while (it != last && !(now < it->second.second)) ++it; }
+
+	public:
+		__skip_ttl_iterator() {}
+		// 指向it所指的元素，之后递增时跳过在now时刻已过期的元素
+		__skip_ttl_iterator(IndexIterator it, IndexIterator last, TimePoint now) : it(it), last(last), now(now) {}
+		// 指向从it开始第一个在now时刻未过期的元素
+		static __skip_ttl_iterator first_live(IndexIterator it, IndexIterator last, TimePoint now) {
+			__skip_ttl_iterator x(it, last, now);
+			x.skip_expired();
+			return x;
+		}
+
+		const Key& key() const { return it->first; }
+		T& value() const { return it->second.first; }
+		// 过期时间，未设置时为time_point::max()
+		TimePoint expiry() const { return it->second.second; }
+		reference operator*() const { return reference(key(), value()); }
+
+		__skip_ttl_iterator& operator++() { ++it; skip_expired(); return *this; }
+		__skip_ttl_iterator operator++(int) { __skip_ttl_iterator tmp = *this; ++*this; return tmp; }
+		bool operator==(const __skip_ttl_iterator &x) const { return it == x.it; }
+		bool operator!=(const __skip_ttl_iterator &x) const { return it != x.it; }
+};
+
+// 支持按元素设置过期时间的skip_map，适用于缓存
+// 过期时间不晚于当前时刻的元素视为不存在：find、count和lower_bound不返回它，迭代时跳过它，operator[]和insert将其视为新插入的key
+// 过期的元素由reap分批删除，reap从按(过期时间, key)排序的过期索引的头部取出已过期的元素，不会访问未过期的元素
+// 插入和修改操作在开始时顺带删除至多reap_on_write个已过期的元素，使写入较多时无需显式调用reap也能回收内存
+// size()包含已过期但尚未被删除的元素
+// 实值与过期时间一同保存在跳表的节点中；过期索引只包含设置了过期时间的元素
+// 两个跳表不能被同时原子地修改，因此不支持单写多读模式
+template <typename Key, typename T, typename Compare = std::less<Key>, size_t MaxLevel = 0,
+		typename Policy = skiplist_default_policy, typename Clock = std::chrono::steady_clock>
+class skip_ttl_map {
+	public:
+		typedef Key key_type;
+		typedef T data_type;
+		typedef T mapped_type;
+		typedef std::pair<const Key, T> value_type;
+		typedef Compare key_compare;
+		typedef Clock clock_type;
+		typedef typename Clock::time_point time_point;
+		typedef typename Clock::duration duration;
+
+	private:
+		static_assert(!Policy::concurrent_readers, "skip_ttl_map does not support concurrent readers");
+
+		// 跳表中的元素为key和(实值, 过期时间)
+		typedef skip_map<Key, std::pair<T, time_point>, Compare, MaxLevel, Policy> index_type;
+		// 过期索引按过期时间排序，过期时间相同时按key排序
+		struct expiry_compare {
+			Compare comp;
+			expiry_compare(const Compare &comp = Compare()) : comp(comp) {}
+			bool operator()(const std::pair<time_point, Key> &a, const std::pair<time_point, Key> &b) const {
+				return a.first < b.first || (!(b.first < a.first) && comp(a.second, b.second));
+			}
+		};
+		typedef skip_set<std::pair<time_point, Key>, expiry_compare, MaxLevel> expiry_type;
+		index_type index;
+		expiry_type expiry_index;
+
+		static time_point never() { return time_point::max(); }
+		// 修改元素的过期时间，同步更新过期索引
+		void __set_expiry(typename index_type::iterator it, time_point when) {
+			time_point &old = it->second.second;
+			if (old == when) return;
+			if (when != never()) expiry_index.insert(std::make_pair(when, it->first));
+			if (old != never()) expiry_index.erase(std::make_pair(old, it->first));
+			old = when;
+		}
+		// 插入或覆盖元素的实值并设置过期时间，key已存在且未过期时返回false
+		template <typename V>
+		std::pair<typename index_type::iterator, bool> __assign(const key_type &k, V &&value, time_point when);
+
+	public:
+		typedef __skip_ttl_iterator<Key, T, typename index_type::iterator, time_point> iterator;
+		typedef typename iterator::reference reference;
+		typedef typename index_type::size_type size_type;
+		typedef typename index_type::difference_type difference_type;
+
+	private:
+		// 插入元素并设置过期时间，key已存在且未过期时不修改
+		std::pair<iterator, bool> __insert(const value_type &val, time_point when) {
+			time_point now = Clock::now();
+			typename index_type::iterator it = index.find(val.first);
+			if (it != index.end() && now < it->second.second) return std::pair<iterator, bool>(iterator(it, index.end(), now), false);
+			return std::pair<iterator, bool>(iterator(__assign(val.first, val.second, when).first, index.end(), now), true);
+		}
+
+	public:
+		// 每次插入和修改操作顺带删除的过期元素数的上限
+		static const size_type reap_on_write = 2;
+
+		skip_ttl_map() {}
+		explicit skip_ttl_map(const Compare &comp) : index(comp), expiry_index(expiry_compare(comp)) {}
+
+		key_compare key_comp() const { return index.key_comp(); }
+		// 迭代器跳过在调用begin时已过期的元素
+		iterator begin() const { return iterator::first_live(index.begin(), index.end(), Clock::now()); }
+		iterator end() const { return iterator(index.end(), index.end(), time_point()); }
+		bool empty() const { return index.empty(); }
+		size_type size() const { return index.size(); }
+		size_type max_size() const { return index.max_size(); }
+		void swap(skip_ttl_map<Key, T, Compare, MaxLevel, Policy, Clock> &rhs) {
+			index.swap(rhs.index);
+			expiry_index.swap(rhs.expiry_index);
+		}
+
+		// 查找操作，已过期的元素视为不存在
+		iterator find(const key_type &k) const {
+			time_point now = Clock::now();
+			typename index_type::iterator it = index.find(k);
+			if (it == index.end() || !(now < it->second.second)) return end();
+			return iterator(it, index.end(), now);
+		}
+		iterator lower_bound(const key_type &k) const { return iterator::first_live(index.lower_bound(k), index.end(), Clock::now()); }
+		size_type count(const key_type &k) const { return find(k) != end(); }
+
+		// 插入操作，key已存在且未过期时不修改实值并返回该元素的迭代器和false
+		// ttl为存活时间，不指定时元素不会过期
+		std::pair<iterator, bool> insert(const value_type &val) { return __insert(val, never()); }
+		std::pair<iterator, bool> insert(const value_type &val, duration ttl) { return __insert(val, Clock::now() + ttl); }
+		// 插入或覆盖，覆盖时同时替换过期时间，不指定ttl时元素不再过期
+		template <typename V>
+		std::pair<iterator, bool> insert_or_assign(const key_type &k, V &&value) {
+			std::pair<typename index_type::iterator, bool> r = __assign(k, std::forward<V>(value), never());
+			return std::pair<iterator, bool>(iterator(r.first, index.end(), Clock::now()), r.second);
+		}
+		template <typename V>
+		std::pair<iterator, bool> insert_or_assign(const key_type &k, V &&value, duration ttl) {
+			std::pair<typename index_type::iterator, bool> r = __assign(k, std::forward<V>(value), Clock::now() + ttl);
+			return std::pair<iterator, bool>(iterator(r.first, index.end(), Clock::now()), r.second);
+		}
+
+		// 重载下标运算符，key不存在或已过期时插入T的默认值，新元素不会过期
+		T& operator[](const key_type &k) {
+			typename index_type::iterator it = index.find(k);
+			if (it != index.end() && Clock::now() < it->second.second) return it->second.first;
+			return __assign(k, T(), never()).first->second.first;
+		}
+
+		// 设置未过期元素的存活时间或过期时刻，元素不存在或已过期时返回false
+		bool expire(const key_type &k, duration ttl) { return expire_at(k, Clock::now() + ttl); }
+		bool expire_at(const key_type &k, time_point when) {
+			typename index_type::iterator it = index.find(k);
+			if (it == index.end() || !(Clock::now() < it->second.second)) return false;
+			__set_expiry(it, when);
+			return true;
+		}
+		// 取消未过期元素的过期时间
+		bool persist(const key_type &k) { return expire_at(k, never()); }
+
+		// 删除操作
+		void erase(const key_type &k) {
+			typename index_type::iterator it = index.find(k);
+			if (it == index.end()) return;
+			__set_expiry(it, never());
+			index.erase(k);
+		}
+		void clear() {
+			index.clear();
+			expiry_index.clear();
+		}
+
+		// 删除至多max_count个已过期的元素，返回删除的元素数
+		// 只访问过期索引的头部，遇到第一个未过期的元素即停止
+		size_type reap(size_type max_count = 64) {
+			time_point now = Clock::now();
+			size_type reaped = 0;
+			while (reaped < max_count && !expiry_index.empty()) {
+				typename expiry_type::iterator first = expiry_index.begin();
+				if (now < first->first) break;
+				index.erase(first->second);
+				expiry_index.pop_front();
+				++reaped;
+			}
+			return reaped;
+		}
+		// 设置了过期时间的元素数，其中包括已过期但尚未被删除的元素
+		size_type expiring() const { return expiry_index.size(); }
+};
+
+template <typename Key, typename T, typename Compare, size_t MaxLevel, typename Policy, typename Clock>
+template <typename V>
+std::pair<typename skip_ttl_map<Key, T, Compare, MaxLevel, Policy, Clock>::index_type::iterator, bool>
+skip_ttl_map<Key, T, Compare, MaxLevel, Policy, Clock>::__assign(const key_type &k, V &&value, time_point when) {
+	reap(reap_on_write);
+	typename index_type::iterator it = index.find(k);
+	bool inserted = it == index.end() || !(Clock::now() < it->second.second);
+	if (it == index.end()) {
+		it = index.insert(std::make_pair(k, std::make_pair(T(std::forward<V>(value)), never()))).first;
+	} else {
+		it->second.first = std::forward<V>(value);
+	}
+	__set_expiry(it, when);
+	return std::pair<typename index_type::iterator, bool>(it, inserted);
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef SKIP_VLOG_MAP_H
+#define SKIP_VLOG_MAP_H
+
+#include <functional>
+#include <iterator>
+#include "skip_map.h"
+#include "skiplist_value_log.h"
+
+// skip_vlog_map的迭代器，解引用得到key和实值的引用组成的pair
+// 只有读取实值时才访问值日志，遍历和比较key时只访问跳表的节点
+template <typename Key, typename T, typename IndexIterator>
+class __skip_vlog_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef std::pair<const Key, T> value_type;
+		typedef std::pair<const Key&, T&> reference;
+		typedef void pointer;
+		typedef ptrdiff_t difference_type;
+
+	private:
+		IndexIterator it;
+
+	public:
+		__skip_vlog_iterator() {}
+		__skip_vlog_iterator(IndexIterator it) : it(it) {}
+
+		const Key& key() const { return it->first; }
+		T& value() const { return it->second->entry().second; }
+		// 构造引用只计算实值的地址，不读取日志中的记录
+		reference operator*() const { return reference(key(), value()); }
+
+		__skip_vlog_iterator& operator++() { ++it; return *this; }
+		__skip_vlog_iterator operator++(int) { __skip_vlog_iterator tmp = *this; ++it; return tmp; }
+		bool operator==(const __skip_vlog_iterator &x) const { return it == x.it; }
+		bool operator!=(const __skip_vlog_iterator &x) const { return it != x.it; }
+};
+
+// 键值分离的skip_map，适用于实值很大（如数KB）的场景
+// 跳表的节点中只保存key和指向值日志中记录的指针，查找和遍历key时访问的内存只与key的数量有关，与实值的大小无关
+// 插入和insert_or_assign将实值追加到值日志中，覆盖时旧记录成为垃圾；通过迭代器或operator[]也可以直接修改日志中的实值
+// 被覆盖或删除的记录所占的空间由collect回收，回收会移动仍存活的记录，使之前取得的实值引用失效，迭代器仍然有效
+// 值日志在回收时会修改节点，因此不支持单写多读模式
+template <typename Key, typename T, typename Compare = std::less<Key>, size_t MaxLevel = 0, typename Policy = skiplist_default_policy>
+class skip_vlog_map {
+	public:
+		typedef Key key_type;
+		typedef T data_type;
+		typedef T mapped_type;
+		typedef std::pair<const Key, T> value_type;
+		typedef Compare key_compare;
+
+	private:
+		static_assert(!Policy::concurrent_readers, "skip_vlog_map does not support concurrent readers");
+
+		typedef __skiplist_value_log<Key, T> log_type;
+		typedef typename log_type::record record;
+		// 跳表中的元素为key和记录指针
+		typedef skip_map<Key, record*, Compare, MaxLevel, Policy> index_type;
+		index_type index;
+		log_type log;
+
+	public:
+		typedef __skip_vlog_iterator<Key, T, typename index_type::iterator> iterator;
+		typedef typename iterator::reference reference;
+		typedef typename index_type::size_type size_type;
+		typedef typename index_type::difference_type difference_type;
+
+		skip_vlog_map() {}
+		explicit skip_vlog_map(const Compare &comp) : index(comp) {}
+		template <typename InputIterator>
+		skip_vlog_map(InputIterator first, InputIterator last) { insert(first, last); }
+
+		// 拷贝构造，按key的顺序将rhs的元素追加到新的值日志中
+		skip_vlog_map(const skip_vlog_map<Key, T, Compare, MaxLevel, Policy> &rhs) : index(rhs.index.key_comp()) {
+			for (iterator it = rhs.begin(); it != rhs.end(); ++it) insert(value_type(it.key(), it.value()));
+		}
+		skip_vlog_map(skip_vlog_map<Key, T, Compare, MaxLevel, Policy> &&rhs) = default;
+		skip_vlog_map<Key, T, Compare, MaxLevel, Policy>& operator=(const skip_vlog_map<Key, T, Compare, MaxLevel, Policy> &rhs) {
+			skip_vlog_map<Key, T, Compare, MaxLevel, Policy> tmp(rhs);
+			swap(tmp);
+			return *this;
+		}
+		skip_vlog_map<Key, T, Compare, MaxLevel, Policy>& operator=(skip_vlog_map<Key, T, Compare, MaxLevel, Policy> &&rhs) {
+			swap(rhs);
+			return *this;
+		}
+		void swap(skip_vlog_map<Key, T, Compare, MaxLevel, Policy> &rhs) {
+			index.swap(rhs.index);
+			log.swap(rhs.log);
+		}
+
+		key_compare key_comp() const { return index.key_comp(); }
+		iterator begin() const { return index.begin(); }
+		iterator end() const { return index.end(); }
+		bool empty() const { return index.empty(); }
+		size_type size() const { return index.size(); }
+		size_type max_size() const { return index.max_size(); }
+
+		// 查找操作，只访问跳表的节点
+		iterator find(const key_type &k) const { return index.find(k); }
+		iterator lower_bound(const key_type &k) const { return index.lower_bound(k); }
+		size_type count(const key_type &k) const { return index.find(k) != index.end(); }
+
+		// 插入操作，key已存在时不修改实值并返回该元素的迭代器和false
+		std::pair<iterator, bool> insert(const value_type &val) {
+			typename index_type::iterator it = index.find(val.first);
+			if (it != index.end()) return std::pair<iterator, bool>(it, false);
+			record *r = log.append(val.first, val.second);
+			try {
+				return std::pair<iterator, bool>(index.insert(std::make_pair(val.first, r)).first, true);
+			} catch (...) {
+				log.release(r);
+				throw;
+			}
+		}
+		template <typename InputIterator>
+		void insert(InputIterator first, InputIterator last) {
+			for (; first != last; ++first) insert(*first);
+		}
+		// 插入或覆盖，key已存在时将新的实值追加到值日志中，旧记录成为垃圾
+		template <typename V>
+		std::pair<iterator, bool> insert_or_assign(const key_type &k, V &&value) {
+			typename index_type::iterator it = index.find(k);
+			if (it == index.end()) {
+				record *r = log.append(k, std::forward<V>(value));
+				try {
+					return std::pair<iterator, bool>(index.insert(std::make_pair(k, r)).first, true);
+				} catch (...) {
+					log.release(r);
+					throw;
+				}
+			}
+			record *old = it->second;
+			it->second = log.append(k, std::forward<V>(value));
+			log.release(old);
+			return std::pair<iterator, bool>(it, false);
+		}
+
+		// 删除操作
+		void erase(const key_type &k) {
+			typename index_type::iterator it = index.find(k);
+			if (it == index.end()) return;
+			log.release(it->second);
+			index.erase(k);
+		}
+		void clear() {
+			index.clear();
+			log.clear();
+		}
+
+		// 重载下标运算符，key不存在时插入T的默认值
+		T& operator[](const key_type &k) {
+			iterator it = find(k);
+			if (it == end()) it = insert(value_type(k, T())).first;
+			return it.value();
+		}
+
+		// 垃圾回收，释放存活记录的比例不超过max_live的日志段，其中仍存活的记录被移动到日志末尾，返回释放的段数
+		// 每移动一条记录需要按key查找一次跳表以更新节点中的指针
+		size_type collect(double max_live = 0.5) {
+			return log.collect(max_live, [this](record *old, record *moved) {
+				index.find(old->entry().first)->second = moved;
+			});
+		}
+		// 值日志占用的字节数，以及其中被覆盖或删除的记录所占的字节数
+		size_type log_bytes() const { return log.bytes(); }
+		size_type garbage_bytes() const { return log.garbage_bytes(); }
+};
+
+#endif
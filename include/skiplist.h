@@ -1,36 +1,141 @@
 #ifndef SKIPLIST_H
 #define SKIPLIST_H
 
+#include <algorithm>
+#include <exception>
 #include <iterator>
 #include <memory>
+#include <new>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cstdlib>
 #include <cstring>
+#include "skiplist_search.h"
+#include "skiplist_parallel.h"
+#include "skiplist_policy.h"
+#include "skiplist_hash_index.h"
+#include "skiplist_node_pool.h"
+#include "skiplist_frozen_index.h"
 
-// skiplist的节点
-template <typename Value>
-struct __skiplist_node {
-	typedef __skiplist_node<Value>* link_type;
+// 单写多读模式下forward数组的元素，Slot为实际保存的指针或引用
+// 读取时使用acquire语义，写入时使用release语义：写者先初始化新节点（包括元素和forward数组），再写入前驱的forward发布该节点
+// 读者读到新节点时即可看到其完整的内容，因此读者无需加锁或重试
+// 复制构造和复制赋值保持平凡，使forward数组仍可通过bzero清零，写者在发布后的节点间复制链接时需先转换为节点指针
+template <typename Node, typename Slot>
+class __skiplist_atomic_link {
+	private:
+		Slot slot;
+
+	public:
+		__skiplist_atomic_link() = default;
+		__skiplist_atomic_link(Node *p) : slot(p) {}
+		__skiplist_atomic_link& operator=(Node *p) {
+			Slot tmp(p);
+			__atomic_store(&slot, &tmp, __ATOMIC_RELEASE);
+			return *this;
+		}
+
+		operator Node*() const {
+			Slot tmp;
+			__atomic_load(&slot, &tmp, __ATOMIC_ACQUIRE);
+			return tmp;
+		}
+		Node* operator->() const { return *this; }
+};
+
+// 节点forward数组的元素类型，紧凑模式下为32位的节点引用，单写多读模式下以acquire/release语义读写
+template <typename Node, bool Compact, bool Atomic>
+struct __skiplist_link_traits {
+	typedef typename std::conditional<Compact, __skiplist_compact_link<Node>, Node*>::type plain_slot;
+	typedef typename std::conditional<Atomic, __skiplist_atomic_link<Node, plain_slot>, plain_slot>::type link_slot;
+};
+
+// 非紧凑模式下保存forward数组的地址，forward数组与节点结构之间有长度不定的key缓存，因此无法由节点地址计算
+template <typename Slot, bool Compact>
+struct __skiplist_forward_base {
+	Slot *forward_array;
+};
+
+// 紧凑模式下不使用key缓存，forward数组紧跟在节点结构之后，其地址由节点地址计算，不占用节点的空间
+// 对齐到32位引用的大小，使紧跟在节点结构之后的forward数组满足对齐要求
+template <typename Slot>
+struct alignas(uint32_t) __skiplist_forward_base<Slot, true> {
+};
+
+// skiplist的节点，Compact为true时forward数组的元素为32位的节点引用，节点由节点池分配
+// Atomic为true时forward数组的元素以acquire/release语义读写，用于单写多读模式
+template <typename Value, bool Compact = false, bool Atomic = false>
+struct __skiplist_node : __skiplist_forward_base<typename __skiplist_link_traits<__skiplist_node<Value, Compact, Atomic>, Compact, Atomic>::link_slot, Compact> {
+	typedef __skiplist_node<Value, Compact, Atomic>* link_type;
+	// forward数组的元素类型
+	typedef typename __skiplist_link_traits<__skiplist_node, Compact, Atomic>::plain_slot plain_slot;
+	typedef typename __skiplist_link_traits<__skiplist_node, Compact, Atomic>::link_slot link_slot;
+	typedef __skiplist_node_pool<__skiplist_node> pool;
 
 	// 节点值
 	Value value_field;
-	// 节点层级
-	size_t level;
-	// forward是大小为level+1的数组
-	// 元素为指针，指向当前节点在每层的后继节点
-	link_type *forward;
-
-	// 构造函数
-	__skiplist_node(Value value_field, size_t level) : value_field(value_field), level(level) {
-		// forward的大小为level+1，因为层数从0开始
-		forward = new link_type[level+1];
+	// 节点层级，层数上限不超过63，因此使用单字节存储，使以下各字段共占8字节
+	unsigned char level;
+	// forward数组的容量，至少为level+1
+	// 确定性平衡和自适应平衡模式下节点的层级会升降，容量不足时forward会被重新分配到节点之外
+	unsigned char capacity;
+	// 自适应平衡模式下节点创建时随机生成的层级，节点冷却后最多降低到该层级
+	unsigned char base_level;
+	// forward是否已被重新分配到节点之外
+	bool external : 1;
+	// 节点是否由compact分配在按key的顺序连续的内存中，释放时需归还到所在的内存段
+	bool sequential : 1;
+	// 自适应平衡模式下访问计数最近一次衰减时的纪元
+	unsigned short stamp;
+	// 自适应平衡模式下被采样到的访问次数
+	unsigned short hits;
+
+	// 构造函数，forward指向由skiplist分配的、紧跟在节点之后的内存
+	// 节点值可以通过复制或移动构造
+	template <typename V>
+	__skiplist_node(V &&value_field, size_t level, size_t capacity, link_slot *forward)
+		: value_field(std::forward<V>(value_field)), level(level), capacity(capacity), base_level(level), external(false), sequential(false),
+		  stamp(0), hits(0) {
+		__store_forward(forward, std::integral_constant<bool, Compact>());
 		// 初始化分配的内存空间，将内存清零
-		bzero(forward, sizeof(link_type)*(level+1));
-	} 
-	// 析构函数，释放forward指向的动态分配的内存
-	~__skiplist_node() { delete [] forward; }
+		bzero(forward, sizeof(link_slot)*capacity);
+	}
+
+	// forward是大小为capacity的数组
+	// 元素为指针（紧凑模式下为32位引用），指向当前节点在每层的后继节点
+	// forward与节点在同一块内存中分配，位于节点结构及其key缓存之后
+	// 缓存后继key时，forward之后紧跟大小为capacity的数组，第i个元素为第i层后继节点的key
+	// 紧凑模式下forward紧跟在节点结构之后；被重新分配到节点之外时，新数组同样由节点池分配，其引用保存在原数组的第一个元素中
+	link_slot* forward() const { return __load_forward(std::integral_constant<bool, Compact>()); }
+	// 将forward改为指向重新分配到节点之外的数组，紧凑模式下数组必须由节点池分配
+	void relocate(link_slot *array) {
+		external = true;
+		__store_forward(array, std::integral_constant<bool, Compact>());
+	}
+
+	// 非紧凑模式下直接读写保存的地址
+	link_slot* __load_forward(std::false_type) const { return this->forward_array; }
+	void __store_forward(link_slot *array, std::false_type) { this->forward_array = array; }
+	// 紧凑模式下由节点地址计算，只有重新分配到节点之外的数组需要保存引用
+	link_slot* __load_forward(std::true_type) const {
+		uint32_t *inline_forward = reinterpret_cast<uint32_t*>(const_cast<__skiplist_node*>(this) + 1);
+		if (!external) return reinterpret_cast<link_slot*>(inline_forward);
+		return reinterpret_cast<link_slot*>(pool::decode(*inline_forward));
+	}
+	void __store_forward(link_slot *array, std::true_type) {
+		if (external) *reinterpret_cast<uint32_t*>(this + 1) = pool::encode(array);
+	}
+
+	// 节点内联的key缓存，紧跟在节点结构之后
+	void* cache() { return this + 1; }
+	const void* cache() const { return this + 1; }
 };
 
-// skiplist的迭代器
-template <typename Value, typename Ref, typename Ptr>
+// skiplist的迭代器，Node为节点类型
+template <typename Value, typename Ref, typename Ptr, typename Node = __skiplist_node<Value>>
 struct __skiplist_iterator {
 		// 定义迭代器的五种特性，使其适配iterator_traits进行特性提取，并兼容STL算法
 		typedef Value value_type;
@@ -40,10 +145,10 @@ struct __skiplist_iterator {
 		typedef std::forward_iterator_tag iterator_category;
 		typedef ptrdiff_t difference_type;
 
-		typedef __skiplist_iterator<Value, Value&, Value*> iterator;
-		typedef __skiplist_iterator<Value, const Value&, const Value*> const_iterator;
-		typedef __skiplist_iterator<Value, Ref, Ptr> self;
-		typedef __skiplist_node<Value>* link_type;
+		typedef __skiplist_iterator<Value, Value&, Value*, Node> iterator;
+		typedef __skiplist_iterator<Value, const Value&, const Value*, Node> const_iterator;
+		typedef __skiplist_iterator<Value, Ref, Ptr, Node> self;
+		typedef Node* link_type;
 
 		// 迭代器的唯一数据就是一个原生指针
 		link_type node;
@@ -51,6 +156,8 @@ struct __skiplist_iterator {
 		// 构造函数
 		__skiplist_iterator(link_type x = nullptr) : node(x) {}
 		__skiplist_iterator(const iterator &it) : node(it.node) {}
+		// 对iterator而言上面的构造函数即为拷贝构造函数，需显式声明赋值运算符
+		self& operator=(const self &it) = default;
 
 		// 重载解引用运算符
 		reference operator*() const { return node->value_field; }
@@ -58,8 +165,8 @@ struct __skiplist_iterator {
 		pointer operator->() const { return &(operator*()); }
 
 		// 重载递增运算符，因为是单向迭代器类型，所以不支持递减运算符
-		self& operator++() { node = node->forward[0]; return *this; } // 前置递增
-		self& operator++(int) { self tmp = *this; node = node->forward[0]; return *this; } // 后置递增
+		self& operator++() { node = node->forward()[0]; return *this; } // 前置递增
+		self& operator++(int) { self tmp = *this; node = node->forward()[0]; return *this; } // 后置递增
 
 		// 重载==和!=运算符，用于条件判断
 		bool operator==(const iterator &it) const { return node == it.node; }
@@ -68,20 +175,117 @@ struct __skiplist_iterator {
 		bool operator!=(const const_iterator &it) const { return node != it.node; }
 };
 
+// 节点句柄，拥有从跳表中摘除的节点，析构时销毁该节点
+// 通过insert将其重新链接到同类型的跳表中，无需重新分配节点和复制元素
+template <typename Skiplist>
+class __skiplist_node_handle {
+	friend Skiplist;
+	public:
+		typedef typename Skiplist::key_type key_type;
+		typedef typename Skiplist::value_type value_type;
+
+	private:
+		typedef typename Skiplist::link_type link_type;
+		link_type node;
+		// 节点摘除时key缓存所占的字节数，重新插入时若修改后的key所需的缓存超出该值，则需要重新分配节点
+		size_t cache_size;
+
+		__skiplist_node_handle(link_type node, size_t cache_size) : node(node), cache_size(cache_size) {}
+
+	public:
+		// 构造函数，构造空的节点句柄
+		__skiplist_node_handle() : node(nullptr), cache_size(0) {}
+		// 节点句柄只能移动，不能复制
+		__skiplist_node_handle(__skiplist_node_handle &&rhs) noexcept : node(rhs.node), cache_size(rhs.cache_size) { rhs.node = nullptr; }
+		__skiplist_node_handle& operator=(__skiplist_node_handle &&rhs) noexcept {
+			if (this != &rhs) {
+				if (node) Skiplist::destroy_node(node);
+				node = rhs.node;
+				cache_size = rhs.cache_size;
+				rhs.node = nullptr;
+			}
+			return *this;
+		}
+		~__skiplist_node_handle() { if (node) Skiplist::destroy_node(node); }
+
+		bool empty() const { return node == nullptr; }
+		explicit operator bool() const { return node != nullptr; }
+
+		// 获取节点中的元素，句柄不能为空
+		value_type& value() const { return node->value_field; }
+		// 获取节点的key，用于在重新插入前修改key
+		// skip_map的元素中key为const，但节点已从跳表中摘除，修改key不会破坏跳表的有序性
+		key_type& key() const { return const_cast<key_type&>(Skiplist::key(node)); }
+		// 获取节点的实值，只适用于skip_map
+		auto& mapped() const { return node->value_field.second; }
+
+		void swap(__skiplist_node_handle &rhs) noexcept {
+			std::swap(node, rhs.node);
+			std::swap(cache_size, rhs.cache_size);
+		}
+};
+
+// 插入节点句柄的返回值，position为插入的节点或key相同的节点的位置
+// 插入失败时node为原来的节点句柄，否则为空
+template <typename Iterator, typename NodeType>
+struct __skiplist_insert_return {
+	Iterator position;
+	bool inserted;
+	NodeType node;
+};
+
+// 跳表层级的公共规则，skiplist与skip_aggregate_map共用
+// MaxLevel为编译期的层数上限，为0时层数上限在运行期指定，默认为18，最多为63，并随节点数量增长
+template <size_t MaxLevel>
+struct __skiplist_levels {
+	// 默认的层数上限
+	static const size_t default_max_level = MaxLevel ? MaxLevel : 18;
+	// 保存各层前驱节点的update数组的容量，在编译期确定
+	static const size_t capacity = (MaxLevel ? MaxLevel : 63) + 1;
+
+	// 将运行期指定的层数上限限制在[1, capacity-1]范围内
+	static size_t clamp(size_t level) {
+		if (level < 1) return 1;
+		return level < capacity ? level : capacity-1;
+	}
+	// 生成随机数作为节点层级，每次层级向上增长的概率为50%
+	static size_t random(size_t max_level) {
+		size_t level = 1;
+		while (rand() % 2) { if (++level >= max_level) return max_level; }
+		return level;
+	}
+	// 使用指定的随机数引擎生成节点层级，用于多线程并行创建节点
+	template <typename Generator>
+	static size_t random(size_t max_level, Generator &gen) {
+		size_t level = 1;
+		while (gen() & 1) { if (++level >= max_level) return max_level; }
+		return level;
+	}
+	// count个节点所需的层数上限（不小于log2(count)），无需提高或编译期指定了MaxLevel时返回max_level
+	static size_t reserve(size_t count, size_t max_level) {
+		if (MaxLevel || !(count >> max_level)) return max_level;
+		size_t level = max_level;
+		while (count >> level) ++level;
+		return clamp(level);
+	}
+};
+
 // 前置声明，在skiplist中声明友元需要
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
 class skiplist;
 
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-bool operator==(const skiplist<Key, Value, KeyOfValue, Compare> &lhs,
-		const skiplist<Key, Value, KeyOfValue, Compare> &rhs);
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+bool operator==(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &lhs,
+		const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs);
 
-// template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-// bool operator<(const skiplist<Key, Value, KeyOfValue, Compare> &lhs,
-// 		const skiplist<Key, Value, KeyOfValue, Compare> &rhs);
+// template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+// bool operator<(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &lhs,
+// 		const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs);
 
 // skiplist类
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
+// MaxLevel为编译期的层数上限，为0时表示层数上限由构造函数在运行期指定
+// Policy为跳表的策略，例如平衡方式，参见skiplist_policy.h
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel = 0, typename Policy = skiplist_default_policy>
 class skiplist {
 	public:
 		// 定义跳表的基础类型
@@ -94,15 +298,58 @@ class skiplist {
 		typedef size_t size_type;
 		typedef ptrdiff_t difference_type;
 
+	private:
+		// 是否以32位的引用代替forward数组中的指针，只对不使用key缓存（定长key）的跳表生效
+		static const bool compact_links = Policy::compact_links && !__skiplist_key_cache<Key, Compare>::enabled;
+		// 是否允许一个写者与多个读者同时访问跳表
+		static const bool concurrent = Policy::concurrent_readers;
+		// 自适应平衡模式下find会调整节点的层级，读者之间以及读者与写者之间都会产生数据竞争
+		static_assert(!concurrent || Policy::balance != skiplist_adaptive_balance,
+				"adaptive balance modifies the skiplist in find and cannot be used with concurrent readers");
+		static_assert(!concurrent || (Policy::balance == skiplist_random_balance && !Policy::hash_index),
+				"concurrent readers require random balance and no hash index");
+		typedef __skiplist_node<Value, compact_links, concurrent> skiplist_node;
+		typedef skiplist_node* link_type;
+		// forward数组的元素类型
+		typedef typename skiplist_node::link_slot link_slot;
+		// 节点的分配器，紧凑模式下从节点池中分配，使节点可以被32位的引用表示
+		typedef typename std::conditional<compact_links, __skiplist_node_pool<skiplist_node>, __skiplist_heap_allocator>::type node_allocator;
+
+	public:
 		// 定义跳表的专属迭代器
-		typedef __skiplist_iterator<value_type, reference, pointer> iterator;
-		typedef __skiplist_iterator<value_type, const_reference, const_pointer> const_iterator;
+		typedef __skiplist_iterator<value_type, reference, pointer, skiplist_node> iterator;
+		typedef __skiplist_iterator<value_type, const_reference, const_pointer, skiplist_node> const_iterator;
+
+		// 默认的层数上限，若指定了编译期层数上限则使用MaxLevel
+		static const size_type default_max_level = __skiplist_levels<MaxLevel>::default_max_level;
+
+		// 节点句柄，以及插入节点句柄的返回值
+		typedef __skiplist_node_handle<skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>> node_type;
+		typedef __skiplist_insert_return<iterator, node_type> insert_return_type;
+		friend node_type;
+		// 策略指定的观察者
+		typedef typename Policy::observer observer_type;
 
 	private:
-		typedef __skiplist_node<Value> skiplist_node;
-		typedef skiplist_node* link_type;
+		// 查找时保存前驱节点的update数组的容量
+		// 编译期指定了MaxLevel时为MaxLevel+1，否则运行期的层数上限最多为63
+		// 使得update数组的大小在编译期确定，不再依赖变长数组
+		static const size_type update_capacity = __skiplist_levels<MaxLevel>::capacity;
+		// 批量查找时同时进行的查找数，使足够多的缓存缺失重叠以覆盖内存访问的延迟，各查找的状态共约1.5KB，仍可留在L1缓存中
+		static const size_type find_group = 32;
+
+		// 是否使用确定性平衡（1-2-3跳表）
+		static const bool deterministic = Policy::balance == skiplist_deterministic_balance;
+		// 是否根据访问频率调整节点的层级
+		static const bool adaptive = Policy::balance == skiplist_adaptive_balance;
+		// 是否维护key到节点的哈希索引
+		static const bool hash_index = Policy::hash_index;
+		// 哈希索引的类型，不使用哈希索引时为空实现
+		typedef typename std::conditional<hash_index,
+				__skiplist_hash_index<skiplist_node, Key, KeyOfValue, typename Policy::template hasher<Key>>,
+				__skiplist_no_index<skiplist_node>>::type index_type;
 
-		// 层级上限
+		// 层级上限，未指定编译期层数上限时随节点数量自动提高，始终不小于log2(n)
 		size_type max_level;
 		// 当前最高层
 		size_type top_level;
@@ -112,54 +359,356 @@ class skiplist {
 		Compare key_compare;
 		// 头节点
 		link_type header;
+		// 自适应平衡模式下的采样状态：随机数状态、当前纪元内的采样次数和当前纪元
+		size_type sample_seed;
+		size_type sample_count;
+		unsigned short epoch;
+		// 哈希索引，与跳表中的节点一一对应
+		index_type index;
+		// 观察者，记录insert、find、erase的延迟和查找路径，默认不记录任何信息
+		// find等常量操作也需要更新统计信息，因此声明为mutable
+		mutable observer_type observer;
+		// 单写多读模式下已摘除但可能仍被读者访问的节点，在reclaim时统一销毁
+		std::vector<link_type> retired;
+		// 增量整理的进度，保存最后一个被重新分配的节点的key，为空时下一次整理从首节点开始
+		std::unique_ptr<key_type> compact_resume;
+		// 冻结后的只读表示，节点按key的顺序连续存放在若干个节点数组中，每个节点只有第0层的链接
+		// 除最后一个数组外每个数组存放per_array个节点，因此可以由秩直接计算出节点的地址，静态B+树search由key得到秩
+		struct frozen_type {
+			struct array {
+				char *base;
+				size_type count;
+			};
+			std::vector<array> arrays;
+			size_type per_array;
+			size_type stride;
+			__skiplist_frozen_index<Key, Compare> search;
+
+			link_type node(size_type rank) const {
+				return reinterpret_cast<link_type>(arrays[rank / per_array].base + rank % per_array * stride);
+			}
+		};
+		// 未冻结时为空
+		std::unique_ptr<frozen_type> frozen_layout;
+
+		// 是否在forward数组旁缓存后继节点的key，要求key可平凡复制且不超过forward数组元素的大小
+		// 避免的是查找时为比较后继的key而访问后继节点所在的缓存行，因此元素只有key时（skip_set）同样有效
+		// 缓存的key不能被原子地读写，因此单写多读模式下不启用
+		static const bool cached_links = Policy::cached_links && !concurrent && std::is_trivially_copyable<Key>::value
+				&& sizeof(Key) <= sizeof(link_slot) && alignof(Key) <= alignof(link_slot);
+		// 每层占用的forward数组元素大小的槽数，缓存后继key时每层还需一个槽存放key
+		static const size_type link_slots = cached_links ? 2 : 1;
 
 	private:
 		// 生成随机数作为节点层级
-		size_type random_level();
-		// 创建一个节点
-		link_type create_node(const value_type &val, size_t level) { return new skiplist_node(val, level); }
-		// 销毁一个节点
-		void destroy_node(link_type node) { delete node; }
-		// 初始化头节点
-		void init() { header = create_node(value_type(), max_level); }
+		size_type random_level() { return __skiplist_levels<MaxLevel>::random(max_level); }
+		// 使用指定的随机数引擎生成节点层级，用于多线程并行创建节点
+		template <typename Generator>
+		size_type random_level(Generator &gen) { return __skiplist_levels<MaxLevel>::random(max_level, gen); }
+		// 创建一个节点，节点结构、key缓存和forward数组在同一块内存中分配，元素通过复制或移动构造
+		// sequential为true时在连续的内存中依次分配，用于compact按key的顺序重新分配节点
+		template <typename V>
+		static link_type create_node(V &&val, size_t level, bool sequential = false);
+		// 销毁一个节点，forward被重新分配到节点之外时需要单独释放
+		static void destroy_node(link_type node) {
+			bool sequential = node->sequential;
+			if (node->external) deallocate_forward(node->forward());
+			node->~skiplist_node();
+			node_allocator::deallocate(node, sequential);
+		}
+		// 分配和释放重新分配到节点之外的forward数组（含后继key数组），紧凑模式下由节点池分配，使其可以被32位的引用表示
+		static link_slot* allocate_forward(size_type capacity) {
+			if (compact_links) return static_cast<link_slot*>(node_allocator::allocate(sizeof(link_slot)*capacity*link_slots));
+			return new link_slot[capacity*link_slots];
+		}
+		static void deallocate_forward(link_slot *forward) {
+			if (compact_links) node_allocator::deallocate(forward);
+			else delete [] forward;
+		}
+		// 节点的key缓存所占的字节数，向上对齐到指针大小
+		static size_type cache_bytes(const key_type &k) {
+			return (key_cache::size(k) + sizeof(link_type) - 1) / sizeof(link_type) * sizeof(link_type);
+		}
+		// 调整节点的层级，容量不足时按倍增的方式重新分配forward数组，新增的层由调用者负责链接
+		void __set_level(link_type node, size_type level);
+		// 初始化头节点，头节点的层数为层数上限
+		// 单写多读模式下头节点的forward数组一次分配到最大容量，使提高层数上限时不会重新分配读者正在访问的数组
+		void init() {
+			header = create_node(value_type(), concurrent ? update_capacity - 1 : level_limit());
+			header->level = level_limit();
+		}
+		// 被移动后的跳表共用的空header，各层均为空，只会被读取
+		// 移动构造将其交给rhs而不分配内存，rhs在第一次修改前由__own_header分配自己的header
+		static link_type __empty_header() {
+			static link_type empty = create_node(value_type(), update_capacity - 1);
+			return empty;
+		}
+		bool __owns_header() const { return header != __empty_header(); }
+		void __own_header() { if (!__owns_header()) init(); }
+		// 获取头节点的层数，编译期指定了MaxLevel时为常量
+		size_type level_limit() const { return MaxLevel ? MaxLevel : max_level; }
+		// 将运行期指定的层数上限限制在[1, update_capacity-1]范围内
+		static size_type clamp_level(size_type level) { return __skiplist_levels<MaxLevel>::clamp(level); }
+		// 将运行期的层数上限提高到level，并扩展header的forward数组，编译期指定了MaxLevel时不做任何事
+		void __raise_level(size_type level) {
+			if (MaxLevel || level <= max_level) return;
+			max_level = clamp_level(level);
+			__set_level(header, max_level);
+		}
+		// 节点数量超过2^max_level时提高层数上限，使随机层级不会被过低的上限截断，查找始终保持最优的深度
+		// 层数上限只增不减，每次提高需重新分配header的forward数组，但n个节点最多只会提高O(log n)次
+		void __grow() { __reserve_level(node_count); }
+		// 按count个节点所需的层数上限（不小于log2(count)）提高层数上限，批量创建节点前调用，使新节点的随机层级不被截断
+		void __reserve_level(size_type count) { __raise_level(__skiplist_levels<MaxLevel>::reserve(count, max_level)); }
 
 		// 用于获得节点的value和key
 		static reference value(link_type x) { return x->value_field; }
 		static const Key& key(link_type x) { return KeyOfValue()(value(x)); }
 
+		// 查找策略，算术类型的key使用无分支的查找步进
+		typedef __skiplist_search_traits<Key, Compare> search_traits;
+		// 节点内联的key缓存，std::string类型的key缓存其前缀和字节
+		typedef __skiplist_key_cache<Key, Compare> key_cache;
+		typedef typename key_cache::probe_type probe_type;
+
+		// 判断节点x的key是否小于k，p为k预处理后的结果
+		bool key_less(link_type x, const key_type &k, const probe_type &p) const {
+			if (key_cache::enabled) return key_cache::compare(x->cache(), p) < 0;
+			return key_compare(key(x), k);
+		}
+		// 判断key大于等于k的节点x的key是否等于k
+		bool key_equal(link_type x, const key_type &k) const {
+			if (key_cache::enabled) return key_cache::compare(x->cache(), key_cache::probe(k)) == 0;
+			return !key_compare(k, key(x));
+		}
+
+		// 节点x中缓存的各层后继节点的key，位于forward数组之后
+		static key_type* link_keys(link_type x) { return reinterpret_cast<key_type*>(x->forward() + x->capacity); }
+		// 将next设置为x在第i层的后继，缓存后继key时同时更新缓存
+		static void __set_next(link_type x, size_type i, link_type next) {
+			x->forward()[i] = next;
+			if (cached_links && next) link_keys(x)[i] = key(next);
+		}
+		// 将x在第i层的后继设置为y在第i层的后继，缓存的key直接从y中复制，无需访问后继节点
+		// 单写多读模式下经由节点指针复制，使写入为release语义
+		static void __copy_next(link_type x, size_type i, link_type y) {
+			if (concurrent) x->forward()[i] = link_type(y->forward()[i]);
+			else x->forward()[i] = y->forward()[i];
+			if (cached_links) link_keys(x)[i] = link_keys(y)[i];
+		}
+		// 判断节点x在第i层的后继next的key是否小于k，缓存后继key时只访问x
+		bool next_less(link_type x, link_type next, size_type i, const key_type &k, const probe_type &p) const {
+			if (cached_links) return key_compare(link_keys(x)[i], k);
+			return key_less(next, k, p);
+		}
+		// 判断节点x在第0层的后继next（存在且key大于等于k）的key是否等于k
+		// next由调用者读取并传入，使单写多读模式下判断的节点与返回的节点相同
+		bool next_equal(link_type x, link_type next, const key_type &k) const {
+			if (cached_links) return !key_compare(k, link_keys(x)[0]);
+			return key_equal(next, k);
+		}
+		// 返回第0层中pred之后第一个key不小于k的节点，pred为查找得到的前驱节点，前进时一并更新
+		// 单写多读模式下，查找结束后写者可能已在pred之后插入了key小于k的节点，因此需要继续前进；其他模式下直接返回pred的后继
+		link_type __first_not_less(link_type &pred, const key_type &k) const {
+			link_type next = pred->forward()[0];
+			if (concurrent) {
+				while (next && key_compare(key(next), k)) {
+					pred = next;
+					next = pred->forward()[0];
+				}
+			}
+			return next;
+		}
+		// 读取和修改当前最高层，单写多读模式下读者与写者同时访问，使用原子操作
+		size_type __top_level() const {
+			return concurrent ? __atomic_load_n(&top_level, __ATOMIC_ACQUIRE) : top_level;
+		}
+		void __set_top_level(size_type level) {
+			if (concurrent) __atomic_store_n(&top_level, level, __ATOMIC_RELEASE);
+			else top_level = level;
+		}
+		// 最高层为空时降低最高层
+		void __trim_top_level() {
+			size_type level = top_level;
+			while (level > 0 && !header->forward()[level]) --level;
+			__set_top_level(level);
+		}
+		// 销毁已摘除的节点，单写多读模式下读者可能仍在访问该节点，因此推迟到reclaim时销毁
+		void __dispose(link_type node) {
+			if (concurrent) retired.push_back(node);
+			else destroy_node(node);
+		}
+		// 通过哈希索引查找key等价于k的节点，不存在时返回空
+		link_type __index_find(const key_type &k) const {
+			return index.find(k, [this](const key_type &a, const key_type &b) { return !key_compare(a, b) && !key_compare(b, a); });
+		}
+
+		// 从最高层开始查找，返回第0层中最后一个key小于k的节点（前驱节点）
+		// 若update不为空，则将每层的前驱节点保存到update中，每层前进的步数报告给trace
+		template <typename Trace>
+		link_type __search(const key_type &k, link_type *update, Trace &trace) const;
+		link_type __search(const key_type &k, link_type *update) const {
+			__skiplist_no_trace trace;
+			return __search(k, update, trace);
+		}
+
 		// 用于插入和删除节点的核心函数
 		iterator __insert(link_type *update, const value_type &val);
 		void __erase(const key_type &k);
+		// 将层级已确定的节点链接到跳表中，update为查找得到的各层前驱节点
+		link_type __link(link_type *update, link_type node);
+		// 将key对应的节点从跳表中摘除但不销毁，返回被摘除的节点，key不存在时返回空
+		template <typename Trace>
+		link_type __unlink(const key_type &k, Trace &trace);
+		link_type __unlink(const key_type &k) {
+			__skiplist_no_trace trace;
+			return __unlink(k, trace);
+		}
+
+		// 确定性平衡模式下插入和删除节点后，自底向上修复节点过多和节点过少的间隔
+		// update为插入或删除时查找得到的各层前驱节点
+		void __insert_fixup(link_type *update);
+		void __erase_fixup(link_type *update);
+		// 确定性平衡模式下，按节点的顺序重新分配所有节点的层级
+		// 用于merge、split等批量修改节点链接的操作之后，时间复杂度为O(n)
+		void __rebalance();
+
+		// 自适应平衡模式下判断本次查找是否被采样，使用xorshift生成随机数
+		bool __sampled() {
+			sample_seed ^= sample_seed << 13;
+			sample_seed ^= sample_seed >> 7;
+			sample_seed ^= sample_seed << 17;
+			return (sample_seed & ((size_type(1) << Policy::sample_shift) - 1)) == 0;
+		}
+		// 衰减节点的访问计数，每经过一个纪元计数减半
+		void __decay(link_type x) const {
+			unsigned short elapsed = epoch - x->stamp;
+			x->hits = elapsed >= 16 ? 0 : x->hits >> elapsed;
+			x->stamp = epoch;
+		}
+		// 根据访问计数计算节点的目标层级
+		// 每个纪元的采样次数与节点数相当，稳定时计数约为节点的访问频率与平均访问频率之比r的2倍
+		// 层级每增加一层节点数约减半，因此r倍于平均频率的节点应比随机层级高log2(r)层
+		// 为避免均匀负载下的计数抖动引起无谓的提升，实际少提升一层，即r至少为4时才提升
+		size_type __target_level(link_type x) const {
+			size_type level = std::min(size_type(x->base_level), max_level);
+			for (unsigned int r = x->hits >> 3; r && level < max_level; r >>= 1) ++level;
+			return level;
+		}
+		// 自适应平衡模式下的查找，被采样时沿查找路径降低已冷却的节点，并按访问计数提升目标节点
+		link_type __adaptive_find(const key_type &k);
+
+		// 将节点x重新分配到连续的内存中，update为x在各层的前驱，完成后将x所在各层的前驱更新为新节点
+		void __relocate(link_type x, link_type *update);
+
+		// 冻结后第rank个节点，rank等于节点数量时为空
+		link_type __frozen_node(size_type rank) const { return rank < node_count ? frozen_layout->node(rank) : nullptr; }
+		// 冻结后查找第一个key不小于k的节点
+		link_type __frozen_lower_bound(const key_type &k) const { return __frozen_node(frozen_layout->search.lower_bound(k, key_compare)); }
+		// 析构冻结的前constructed个节点并释放所有节点数组
+		void __destroy_frozen(frozen_type &layout, size_type constructed);
+
+		// 按rhs的节点结构复制所有节点，要求当前跳表为空
+		// rhs已冻结时按冻结前的层级创建节点
+		void __clone(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs);
+
+		// 批量追加节点，用于以线性时间构造跳表
+		// tail保存每层的最后一个节点，初始时均为header，要求追加的节点的key递增
+		// 追加节点时层数上限可能提高，因此初始化update_capacity层，而不只是当前的层数上限
+		void __init_tail(link_type *tail) const {
+			for (size_type i = 0; i < update_capacity; ++i) tail[i] = header;
+		}
+		void __append(link_type *tail, link_type node);
+		// 断开所有节点与header的链接，使跳表为空，但不销毁节点
+		void __detach();
+		// 查找每层的最后一个节点，保存到tail中，未使用的层为header
+		void __last_path(link_type *tail) const;
+		// 以线性时间进行集合运算，将结果追加到空跳表result中
+		// 三个参数分别表示是否保留只在当前跳表中、同时在两个跳表中、只在rhs中的元素
+		void __set_operation(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs,
+				skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &result,
+				bool keep_left, bool keep_both, bool keep_right) const;
+
+		// 并行排序，先由各线程分别对一段数据进行稳定排序，再逐轮两两归并
+		template <typename RandomIterator, typename LessCompare>
+		static void __parallel_sort(RandomIterator first, RandomIterator last, LessCompare less, size_type threads);
+		// 输入为前向迭代器且元素类型与value_type相同时，直接对指向输入元素的指针排序，否则先将输入复制到缓冲区
+		// 两种情况下每个元素都只被复制一次
+		template <typename ForwardIterator>
+		void __insert_parallel(ForwardIterator first, ForwardIterator last, size_type threads, std::true_type);
+		template <typename InputIterator>
+		void __insert_parallel(InputIterator first, InputIterator last, size_type threads, std::false_type);
+		// 对指向元素的指针并行排序并去重（key重复时保留先出现的元素），再创建节点并合并到当前跳表中
+		template <typename Pointer>
+		void __insert_sorted(std::vector<Pointer> &sorted, size_type threads);
+		// 将按key严格递增的元素分段，由各线程并行创建节点并在段内链接各层，最后将各段逐层首尾相连
+		// Pointer指向非const元素时，元素被移动到节点中
+		// 要求当前跳表为空
+		template <typename Pointer>
+		void __parallel_link(const std::vector<Pointer> &sorted, size_type threads);
+		// 利用高层的节点将key在[lo, hi)范围内的节点划分为约chunks个连续的块
+		// bounds[i]和bounds[i+1]分别为第i块的首节点和最后一个节点的后继
+		void __partition(const key_type &lo, const key_type &hi, size_type chunks, std::vector<link_type> &bounds) const;
 		
 	public:
 		// 构造函数
 		skiplist(size_type max_level, const Compare &comp = Compare())
-			: max_level(max_level), top_level(0), node_count(0), key_compare(comp) { init(); }
+			: max_level(clamp_level(max_level)), top_level(0), node_count(0), key_compare(comp),
+			  sample_seed(88172645463325252ull), sample_count(0), epoch(0) { init(); }
 
 		// 拷贝构造，需复制对象的底层资源
-		// 先利用委托构造函数初始化一个空跳表
-		// 再复制所有节点值（value_field），不复制节点结构（level和forward）
-		skiplist(const skiplist<Key, Value, KeyOfValue, Compare> &rhs)
-			: skiplist(rhs.max_level, rhs.key_compare) { insert_unique(rhs.begin(), rhs.end()); }
-		// 拷贝赋值，利用按值传递来自动处理自赋值的情况，并确保异常安全
-		// 但按值传递会调用拷贝构造，所以自赋值时会改变节点结构（level和forward）
-		skiplist<Key, Value, KeyOfValue, Compare>& operator=(skiplist<Key, Value, KeyOfValue, Compare> rhs) {
+		// 先利用委托构造函数初始化一个空跳表，使得复制过程中抛出异常时已复制的节点能被析构函数释放
+		// 再按rhs的节点结构逐个复制节点（包括level），时间复杂度为O(n)
+		// rhs已冻结时，按冻结前的层级复制后再冻结副本
+		skiplist(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs)
+			: skiplist(rhs.max_level, rhs.key_compare) {
+			__clone(rhs);
+			if (rhs.frozen_layout) freeze();
+		}
+		// 移动构造，直接接管rhs的header，rhs改为使用共用的空header，不分配内存
+		// 被移动后的跳表是空跳表，所有成员函数都可以正常使用，第一次修改时才分配自己的header
+		skiplist(skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &&rhs) noexcept(std::is_nothrow_move_constructible<Compare>::value)
+			: max_level(rhs.max_level), top_level(rhs.top_level), node_count(rhs.node_count), key_compare(std::move(rhs.key_compare)),
+			  header(rhs.header), sample_seed(rhs.sample_seed), sample_count(rhs.sample_count), epoch(rhs.epoch), index(std::move(rhs.index)),
+			  retired(std::move(rhs.retired)), compact_resume(std::move(rhs.compact_resume)), frozen_layout(std::move(rhs.frozen_layout)) {
+			rhs.header = __empty_header();
+			rhs.top_level = 0;
+			rhs.node_count = 0;
+		}
+		// 拷贝赋值，先复制到临时跳表再交换，以确保异常安全，自赋值时直接返回
+		skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>& operator=(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs) {
+			if (this != &rhs) {
+				skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> tmp(rhs);
+				swap(tmp);
+			}
+			return *this;
+		}
+		// 移动赋值，与rhs交换，原有的节点由rhs负责释放
+		skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>& operator=(skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &&rhs)
+				noexcept(std::is_nothrow_swappable<Compare>::value) {
 			swap(rhs);
 			return *this;
 		}
 		// 交换操作
-		void swap(skiplist<Key, Value, KeyOfValue, Compare> &rhs);
+		void swap(skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs);
 
 		// 析构函数，需要先清空跳表，再释放头节点
-		~skiplist() { clear(); destroy_node(header); }
+		~skiplist() {
+			clear();
+			if (__owns_header()) destroy_node(header);
+		}
 		
 		// 获取作为节点间键值大小比较准则的函数对象
 		Compare key_comp() const { return key_compare; }
+		// 获取运行期的层数上限
+		size_type get_max_level() const { return max_level; }
+		// 获取观察者，用于读取观察者记录的统计信息
+		observer_type& get_observer() const { return observer; }
 
 		// 首尾迭代器，首迭代器即头节点在第0层的后继
 		// 因为是单向链表，所以无反向迭代器
-		iterator begin() const { return header->forward[0]; }
-		const_iterator cbegin() const { return header->forward[0]; }
+		iterator begin() const { return iterator(header->forward()[0]); }
+		const_iterator cbegin() const { return const_iterator(header->forward()[0]); }
 		iterator end() const { return nullptr; }
 		const_iterator cend() const { return nullptr; }
 
@@ -168,128 +717,524 @@ class skiplist {
 		size_type size() const { return node_count; }
 		size_type max_size() const { return size_type(-1); }
 
+		// 获取key最小的元素，跳表不能为空
+		reference front() const { return header->forward()[0]->value_field; }
+		// 删除key最小的元素，跳表不能为空
+		// 首节点在其所在的每一层都是第一个节点，前驱均为header，因此无需查找，期望时间复杂度为O(1)
+		void pop_front();
+
 		// 将节点插入跳表中，并保证节点唯一
 		std::pair<iterator, bool> insert_unique(const value_type &val);
 		// 将一对迭代器[first, last)表示的范围内的数据插入跳表中
 		template <typename InputIterator>
 		void insert_unique(InputIterator first, InputIterator last);
+		// 使用多个线程将一对迭代器[first, last)表示的范围内的无序数据插入跳表中
+		// 先并行排序并去重（key重复时保留先出现的元素），再并行创建并链接节点
+		template <typename InputIterator>
+		void insert_unique(InputIterator first, InputIterator last, const skiplist_parallel &policy);
+		// 插入节点句柄所拥有的节点，直接链接原有节点而不重新分配
+		// 若key已存在，则插入失败，节点仍由返回值中的node拥有
+		insert_return_type insert_unique(node_type &&nh);
 		// iterator insert_equal(const value_type &val);
 
 		// 根据key在跳表中查找节点
+		// 自适应平衡模式下find会调整被采样节点的层级，虽然是const成员函数，多个线程同时查找时也需要外部同步
 		iterator find(const key_type &k) const;
+		// 批量查找[first, last)中的每个key，第i个key的查找结果（不存在时为尾迭代器）写入result[i]
+		// 同时进行find_group个查找，每个查找在访问下一个节点前先预取该节点并切换到其他查找（AMAC）
+		// 使多个查找的缓存缺失同时进行，适用于跳表远大于末级缓存、key无序且彼此独立的批量查找
+		// 维护哈希索引、自适应平衡或已冻结时逐个调用find；批量查找不经过观察者
+		template <typename ForwardIterator, typename RandomAccessIterator>
+		void find_many(ForwardIterator first, ForwardIterator last, RandomAccessIterator result) const;
+		// 查找第一个key不小于k的节点，不存在时返回尾迭代器
+		iterator lower_bound(const key_type &k) const {
+			if (frozen_layout) return iterator(__frozen_lower_bound(k));
+			link_type pred = __search(k, nullptr);
+			return iterator(__first_not_less(pred, k));
+		}
+
+		// 只读游标，保存当前元素在每层的前驱节点（即查找时update数组的内容），用于向递增的key反复定位（如归并连接）
+		// 向后定位时先从第0层向上，找到第一个后继不小于目标key的层，再从该层的前驱向下查找，期望代价为O(log d)，d为跨过的元素数
+		// 目标key不大于当前前驱的key时从header重新查找；跳表已冻结时通过冻结的索引定位
+		// 游标存在期间修改跳表（包括自适应平衡模式下的find）会使游标失效；单写多读模式下与迭代器相同，reclaim之前保持有效
+		class cursor {
+			private:
+				const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> *list;
+				link_type current;
+				link_type path[update_capacity];
+
+			public:
+				// 创建指向第一个元素的游标
+				explicit cursor(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &l) : list(&l) { rewind(); }
+
+				// 回到第一个元素
+				void rewind() {
+					for (size_type i = 0; i < update_capacity; ++i) path[i] = list->header;
+					current = list->header->forward()[0];
+				}
+				// 定位到第一个key不小于k的元素
+				void seek(const key_type &k);
+				// 前进到下一个元素，要求游标有效；当前节点成为其所在各层的前驱
+				void next() {
+					link_type x = current;
+					for (size_type i = 0; i <= x->level; ++i) path[i] = x;
+					current = x->forward()[0];
+				}
+
+				// 游标是否指向元素，越过最后一个元素后无效
+				bool valid() const { return current != nullptr; }
+				const_reference operator*() const { return current->value_field; }
+				const_pointer operator->() const { return &(operator*()); }
+				const_iterator position() const { return const_iterator(current); }
+		};
+		cursor get_cursor() const { return cursor(*this); }
+
+		// 并行遍历key在[lo, hi)范围内的所有元素，对每个元素调用fn，fn会被多个线程同时调用
+		template <typename Function>
+		void parallel_for_each(const key_type &lo, const key_type &hi, Function fn,
+				const skiplist_parallel &policy = skiplist_parallel()) const;
+		// 并行归约key在[lo, hi)范围内的所有元素，init应为归约操作的单位元
+		// 每个块从init开始调用op(acc, 元素)进行累积，再按key的顺序调用combine(acc, 块的结果)合并各块的结果
+		template <typename T, typename BinaryOperation, typename Combine>
+		T parallel_reduce(const key_type &lo, const key_type &hi, T init, BinaryOperation op, Combine combine,
+				const skiplist_parallel &policy = skiplist_parallel()) const;
 
 		// 根据key在跳表中删除节点
-		void erase(const key_type &k) { __erase(k); }
+		void erase(const key_type &k) {
+			if (frozen_layout) {
+				key_type tmp(k);
+				thaw();
+				__erase(tmp);
+				return;
+			}
+			__erase(k);
+		}
 		// 将一对迭代器[first, last)表示的范围内的节点从跳表中删除
 		void erase(const_iterator first, const_iterator last);
+		// 单写多读模式下，erase和pop_front摘除的节点可能仍被读者访问，因此推迟到调用reclaim时销毁
+		// 由写者在没有读者访问跳表时（静止点）调用，其他模式下不做任何事
+		void reclaim() {
+			for (link_type node : retired) destroy_node(node);
+			retired.clear();
+		}
+
+		// 将key对应的节点从跳表中摘除，返回拥有该节点的句柄，key不存在时返回空句柄
+		node_type extract(const key_type &k) {
+			if (frozen_layout) {
+				key_type tmp(k);
+				thaw();
+				return extract(tmp);
+			}
+			link_type node = __unlink(k);
+			return node ? node_type(node, cache_bytes(key(node))) : node_type();
+		}
+		// 将迭代器指向的节点从跳表中摘除，由于跳表是单向链表，仍需通过key查找各层的前驱
+		node_type extract(const_iterator position) { return extract(KeyOfValue()(*position)); }
 
 		// 清空跳表
 		void clear();
 
+		// 增量整理：按key的顺序将节点重新分配到连续的内存中并改写各层的链接，每次调用最多移动steps个节点
+		// 已冻结时节点已经按key的顺序连续存放，不做任何事并返回true
+		// 长时间随机插入和删除后节点散布在堆中，整理后第0层的遍历近似于顺序访问内存，原来的节点所占的内存也可被归还
+		// 返回true表示已整理到末尾，下一次调用从头开始；否则下一次调用从上次移动的最后一个key之后继续，两次调用之间可以任意修改跳表
+		// 被移动的节点的迭代器失效；单写多读模式下由写者调用，原来的节点在reclaim时销毁
+		bool compact(size_type steps = size_type(-1));
+
+		// 冻结：将跳表转换为只读的紧凑表示，节点按key的顺序连续存放且只保留第0层的链接，不再有各层的forward数组
+		// 查找改为在按缓存行分块的静态B+树中无分支地比较key，再由秩直接计算节点的地址；迭代器、find、lower_bound的用法不变
+		// 冻结后的修改操作（插入、删除、摘除、合并、拆分、连接）会先自动解冻，因此会使所有迭代器失效
+		// 以已存在的key插入时不修改跳表，不会解冻；冻结和解冻都会重新分配节点，使所有迭代器失效；已冻结时不做任何事
+		void freeze();
+		// 解冻：按冻结前的层级重新创建节点，恢复为可以修改的跳表，确定性平衡模式下重新分配层级；未冻结时不做任何事
+		void thaw();
+		// 是否已冻结
+		bool frozen() const { return frozen_layout != nullptr; }
+
+		// 将rhs中key不存在于当前跳表的节点转移到当前跳表中，key重复的节点仍保留在rhs中
+		// 只修改节点的链接，不重新分配节点，时间复杂度为O(n+m)
+		// 确定性平衡模式下合并后还要按节点的顺序重新分配两个跳表中所有节点的层级，同为O(n+m)
+		void merge(skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs);
+		// 集合运算，以线性时间计算当前跳表与rhs的并集、交集和差集，结果保存到result中
+		void set_union(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs,
+				skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &result) const { __set_operation(rhs, result, true, true, true); }
+		void set_intersection(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs,
+				skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &result) const { __set_operation(rhs, result, false, true, false); }
+		void set_difference(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs,
+				skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &result) const { __set_operation(rhs, result, true, false, false); }
+
+		// 拆分操作，将key大于等于k的所有节点转移到result中，result中原有的节点会被清空
+		// 只需在查找路径上切断每层的链接，时间复杂度为O(max_level)加上统计较小一侧节点数量的开销
+		// 确定性平衡模式下切断处的间隔可能为空，需重新分配两侧所有节点的层级，时间复杂度为O(n)
+		void split(const key_type &k, skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &result);
+		// 连接操作，将rhs的所有节点连接到当前跳表的末尾，要求rhs中的key均大于当前跳表中的key
+		// 只需将当前跳表每层的最后一个节点链接到rhs每层的首节点，时间复杂度为O(max_level)
+		// 确定性平衡模式下连接处的间隔可能超过3个节点，需重新分配所有节点的层级，时间复杂度为O(n+m)
+		// 若不满足key的大小要求，则退化为merge
+		void join(skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs);
+
 		// 重载关系运算符的友元声明
-		friend bool operator==<Key, Value, KeyOfValue, Compare>(const skiplist<Key, Value, KeyOfValue, Compare> &lhs,
-				const skiplist<Key, Value, KeyOfValue, Compare> &rhs);
-		// friend bool operator< <Key, Value, KeyOfValue, Compare>(const skiplist<Key, Value, KeyOfValue, Compare> &lhs,
-		//		const skiplist<Key, Value, KeyOfValue, Compare> &rhs);
+		friend bool operator==<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &lhs,
+				const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs);
+		// friend bool operator< <Key, Value, KeyOfValue, Compare, MaxLevel, Policy>(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &lhs,
+		//		const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs);
 };
 
 // 定义重载的相等性判断运算符
 // 只判断节点值（value_field）是否相等即可，不需要判断节点结构（level和forward）
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-bool operator==(const skiplist<Key, Value, KeyOfValue, Compare> &lhs,
-		const skiplist<Key, Value, KeyOfValue, Compare> &rhs) {
-	typename skiplist<Key, Value, KeyOfValue, Compare>::link_type lhs_current = lhs.header->forward[0];
-	typename skiplist<Key, Value, KeyOfValue, Compare>::link_type rhs_current = rhs.header->forward[0];
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+bool operator==(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &lhs,
+		const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs) {
+	typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::link_type lhs_current = lhs.header->forward()[0];
+	typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::link_type rhs_current = rhs.header->forward()[0];
 	while (lhs_current && rhs_current) {
 		if (!(lhs.value(lhs_current) == rhs.value(rhs_current))) return false;
-		lhs_current = lhs_current->forward[0];
-		rhs_current = rhs_current->forward[0];
+		lhs_current = lhs_current->forward()[0];
+		rhs_current = rhs_current->forward()[0];
 	}
 	if (lhs_current || rhs_current) return false;
 	return true;
 }
 
 // 交换操作，交换所有节点值（value_field），也交换节点结构（level和forward）
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-void skiplist<Key, Value, KeyOfValue, Compare>::swap(skiplist<Key, Value, KeyOfValue, Compare> &rhs) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::swap(skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs) {
 	std::swap(max_level, rhs.max_level);
 	std::swap(top_level, rhs.top_level);
 	std::swap(node_count, rhs.node_count);
+	std::swap(key_compare, rhs.key_compare);
 	// 交换header即可实现底层资源的置换
 	std::swap(header, rhs.header);
+	// 节点的访问计数以所在跳表的纪元为基准，需一同交换
+	std::swap(sample_seed, rhs.sample_seed);
+	std::swap(sample_count, rhs.sample_count);
+	std::swap(epoch, rhs.epoch);
+	index.swap(rhs.index);
+	retired.swap(rhs.retired);
+	compact_resume.swap(rhs.compact_resume);
+	frozen_layout.swap(rhs.frozen_layout);
 }
 
-// 生成随机数作为节点层级
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-typename skiplist<Key, Value, KeyOfValue, Compare>::size_type
-skiplist<Key, Value, KeyOfValue, Compare>::random_level() {
-	size_type level = 1;
-	// 每次层级向上增长的概率为50%
-	while (rand() % 2) { if (++level >= max_level) return max_level; }
-	return level;
+// 创建一个节点，节点结构、key缓存和forward数组在同一块内存中分配
+// 内存布局为：[节点结构][key缓存][forward数组][后继key数组]，key缓存的大小向上对齐到指针大小，后继key数组只在缓存后继key时存在
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename V>
+typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::link_type
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::create_node(V &&val, size_t level, bool sequential) {
+	const key_type &k = KeyOfValue()(val);
+	size_type cache_size = cache_bytes(k);
+	// 确定性平衡模式下新节点的层级为0，预留一层以免大多数提升操作重新分配forward
+	size_type capacity = level + 1;
+	if (deterministic && capacity < 2) capacity = 2;
+	size_type bytes = sizeof(skiplist_node) + cache_size + sizeof(link_slot)*capacity*link_slots;
+	// 节点过大时无法连续分配，改为单独分配
+	char *p = sequential ? static_cast<char*>(node_allocator::allocate_sequential(bytes)) : nullptr;
+	sequential = p != nullptr;
+	if (!p) p = static_cast<char*>(node_allocator::allocate(bytes));
+	link_slot *forward = reinterpret_cast<link_slot*>(p + sizeof(skiplist_node) + cache_size);
+	link_type node;
+	try {
+		node = new (p) skiplist_node(std::forward<V>(val), level, capacity, forward);
+	} catch (...) {
+		node_allocator::deallocate(p, sequential);
+		throw;
+	}
+	node->sequential = sequential;
+	// 元素可能是从val移动构造的，因此从节点中的key构造缓存
+	key_cache::construct(node->cache(), key(node));
+	if (cached_links) bzero(link_keys(node), sizeof(link_slot)*capacity);
+	return node;
+}
+
+// 调整节点的层级，容量不足时按倍增的方式重新分配forward数组
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__set_level(link_type node, size_type level) {
+	if (level + 1 > node->capacity) {
+		size_type capacity = std::min(std::max(level + 1, size_type(node->capacity) * 2), level_limit() + 1);
+		link_slot *forward = allocate_forward(capacity);
+		bzero(forward, sizeof(link_slot)*capacity*link_slots);
+		memcpy(forward, node->forward(), sizeof(link_slot)*(node->level+1));
+		if (cached_links) memcpy(static_cast<void*>(forward + capacity), link_keys(node), sizeof(key_type)*(node->level+1));
+		if (node->external) deallocate_forward(node->forward());
+		node->relocate(forward);
+		node->capacity = capacity;
+	}
+	node->level = level;
+}
+
+// 从跳表最高层开始查找，返回第0层中最后一个key小于k的节点（前驱节点）
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename Trace>
+typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::link_type
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__search(const key_type &k, link_type *update, Trace &trace) const {
+	// 未被采样的操作使用不记录信息的查找，使其与未启用观察者时执行相同的代码
+	if (!std::is_same<Trace, __skiplist_no_trace>::value && !trace.active()) return __search(k, update);
+	link_type current = header;
+	// 预处理目标key，查找过程中与节点的key缓存进行比较
+	probe_type p = key_cache::probe(k);
+
+	if (search_traits::branchless) {
+		// 无分支的查找步进：每一步要么在当前层前进，要么下降一层
+		// 后继为空时用header代替后继读取key，再通过掩码丢弃该比较结果，从而避免短路求值产生的分支
+		size_type hops = 0;
+		for (int i = __top_level(); i >= 0; ) {
+			link_type next = current->forward()[i];
+			link_type probe = next ? next : header;
+			bool advance = (next != nullptr) & next_less(current, probe, i, k, p);
+			current = advance ? next : current;
+			if (update) update[i] = current;
+			// 不记录信息时hops和以下分支在编译后消失
+			hops += advance;
+			if (!advance) { trace.hops(i, hops); hops = 0; }
+			i -= !advance;
+		}
+		return current;
+	}
+
+	for (int i = __top_level(); i >= 0; --i) {
+		// 若当前节点的后继不为空且后继的key小于目标key
+		// 表明需要在当前层继续前进，继续while循环
+		// 每个后继只读取一次，单写多读模式下比较的节点与前进到的节点相同
+		size_type hops = 0;
+		link_type next = current->forward()[i];
+		while (next && next_less(current, next, i, k, p)) {
+			current = next;
+			next = current->forward()[i];
+			++hops;
+		}
+		trace.hops(i, hops);
+		// 若当前节点的后继为空或后继节点的key大于等于目标节点的key
+		// 则current此时即为目标节点的前一个位置（前驱节点），将其保存到update中
+		if (update) update[i] = current;
+	}
+	return current;
 }
 
 // 将节点插入跳表中，并保证节点唯一
 // 若待插入节点的key不存在，则插入成功，并返回新节点的迭代器和true
 // 若待插入节点的key已存在，则插入失败，并返回key相同的节点的迭代器和false
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-std::pair<typename skiplist<Key, Value, KeyOfValue, Compare>::iterator, bool>
-skiplist<Key, Value, KeyOfValue, Compare>::insert_unique(const value_type &val) {
-	link_type current = header;
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+std::pair<typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::iterator, bool>
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::insert_unique(const value_type &val) {
+	typename observer_type::trace trace(observer, skiplist_op_insert);
 	// 使用update来保存每层中最后一个满足其key小于待插入节点的key的节点（即前驱节点)
-	// update大小设置为max_level+1以确保有足够的空间来存放每层满足条件的节点
-	link_type update[max_level+1];
-	bzero(update, sizeof(link_type)*(max_level+1));
+	// update大小为update_capacity，在编译期确定，且足以存放每层满足条件的节点
+	// 查找会填充[0, top_level]层，__insert会填充新增的层，因此无需清零
+	link_type update[update_capacity];
 
-	// 从跳表最高层开始查找
-	for (int i = top_level; i >= 0; --i) {
-		// 若当前节点的后继不为空且后继的key小于待插入的节点的key
-		// 表明需要在当前层继续前进，继续while循环
-		while (current->forward[i] && key_compare(key(current->forward[i]), KeyOfValue()(val)))
-			current = current->forward[i];
-		// 若当前节点的后继为空或后继节点的key大于等于目标节点的key
-		// 则current此时即为待插入节点的前一个位置（前驱节点），将其保存到update中
-		update[i] = current;
+	// 已冻结时，key已存在则直接返回，否则复制元素（val可能引用冻结的节点）后解冻再插入
+	if (frozen_layout) {
+		link_type node = __frozen_lower_bound(KeyOfValue()(val));
+		if (node && !key_compare(KeyOfValue()(val), key(node))) return std::pair<iterator, bool>(node, false);
+		value_type tmp(val);
+		thaw();
+		return insert_unique(tmp);
+	}
+	__own_header();
+
+	// 维护哈希索引时，key已存在的情况无需查找跳表即可返回，使skip_map的operator[]访问已有元素为O(1)
+	if (hash_index) {
+		link_type node = __index_find(KeyOfValue()(val));
+		if (node) return std::pair<iterator, bool>(node, false);
 	}
 
-	// 当for循环结束时，表明已经查到了第0层
-	// 那么current->forward[0]的key此时可能等于或大于待插入节点的key
-	current = current->forward[0];
+	// 查找到第0层的前驱节点后
+	// current->forward()[0]的key此时可能等于或大于待插入节点的key
+	link_type pred = __search(KeyOfValue()(val), update, trace), current = pred->forward()[0];
 	
 	// 若待插入的key已经存在于跳表中，则不插入新值
-	if (current && !key_compare(KeyOfValue()(val), key(current)))
+	if (current && next_equal(pred, current, KeyOfValue()(val)))
 		return std::pair<iterator, bool>(current, false);
 
 	return std::pair<iterator, bool>(__insert(update, val), true);
 }
 
 // 将一对迭代器[first, last)表示的范围内的数据插入跳表中
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
 template <typename InputIterator>
-void skiplist<Key, Value, KeyOfValue, Compare>::insert_unique(InputIterator first, InputIterator last) {
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::insert_unique(InputIterator first, InputIterator last) {
 	while (first != last) { insert_unique(*first); ++first; }
 }
 
+// 使用多个线程将一对迭代器[first, last)表示的范围内的无序数据插入跳表中
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename InputIterator>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::insert_unique(InputIterator first, InputIterator last, const skiplist_parallel &policy) {
+	typedef typename std::iterator_traits<InputIterator>::reference input_reference;
+	typedef std::integral_constant<bool,
+			std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<InputIterator>::iterator_category>::value
+			&& std::is_lvalue_reference<input_reference>::value
+			&& std::is_same<typename std::decay<input_reference>::type, value_type>::value> addressable;
+	__insert_parallel(first, last, policy.concurrency(), addressable());
+}
+
+// 输入的元素可以取地址，直接对指向输入元素的指针排序，元素在创建节点时被复制
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename ForwardIterator>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__insert_parallel(ForwardIterator first, ForwardIterator last, size_type threads, std::true_type) {
+	std::vector<const value_type*> sorted;
+	sorted.reserve(std::distance(first, last));
+	for (; first != last; ++first) sorted.push_back(&*first);
+	__insert_sorted(sorted, threads);
+}
+
+// 先将输入复制到缓冲区，元素在创建节点时从缓冲区移动到节点中
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename InputIterator>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__insert_parallel(InputIterator first, InputIterator last, size_type threads, std::false_type) {
+	std::vector<value_type> values(first, last);
+	std::vector<value_type*> sorted(values.size());
+	for (size_type i = 0; i < values.size(); ++i) sorted[i] = &values[i];
+	__insert_sorted(sorted, threads);
+}
+
+// 对指针进行排序，因为skip_map的元素类型中key为const，无法直接对元素排序
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename Pointer>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__insert_sorted(std::vector<Pointer> &sorted, size_type threads) {
+	if (sorted.empty()) return;
+	Compare comp = key_compare;
+	auto less = [comp](Pointer x, Pointer y) { return comp(KeyOfValue()(*x), KeyOfValue()(*y)); };
+	// 稳定排序保证key相同的元素保持输入的顺序，去重后保留先出现的元素，与逐个插入的语义一致
+	__parallel_sort(sorted.begin(), sorted.end(), less, threads);
+	sorted.erase(std::unique(sorted.begin(), sorted.end(),
+				[&less](Pointer x, Pointer y) { return !less(x, y); }), sorted.end());
+
+	skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> tmp(max_level, key_compare);
+	tmp.__parallel_link(sorted, threads);
+	// 当前跳表为空时直接交换（冻结的空跳表随tmp一同释放），否则以线性时间将新节点合并进来
+	if (empty()) swap(tmp);
+	else merge(tmp);
+}
+
+// 并行排序，先由各线程分别对一段数据进行稳定排序，再逐轮两两归并
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename RandomIterator, typename LessCompare>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__parallel_sort(RandomIterator first, RandomIterator last, LessCompare less, size_type threads) {
+	size_type n = last - first;
+	if (threads > n) threads = n;
+	if (threads <= 1) { std::stable_sort(first, last, less); return; }
+
+	// bounds[i]为第i段的起始位置
+	std::vector<size_type> bounds(threads+1);
+	for (size_type i = 0; i <= threads; ++i) bounds[i] = n * i / threads;
+
+	std::vector<std::thread> workers;
+	for (size_type i = 0; i < threads; ++i)
+		workers.push_back(std::thread([=]() { std::stable_sort(first+bounds[i], first+bounds[i+1], less); }));
+	for (auto &worker : workers) worker.join();
+
+	// 每轮将相邻的两段归并为一段，各组归并由不同线程同时进行
+	for (size_type width = 1; width < threads; width *= 2) {
+		workers.clear();
+		for (size_type i = 0; i + width < threads; i += 2*width) {
+			size_type lo = bounds[i], mid = bounds[i+width], hi = bounds[std::min(i+2*width, threads)];
+			workers.push_back(std::thread([=]() { std::inplace_merge(first+lo, first+mid, first+hi, less); }));
+		}
+		for (auto &worker : workers) worker.join();
+	}
+}
+
+// 将按key严格递增的元素分段，由各线程并行创建节点并在段内链接各层，最后将各段逐层首尾相连
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename Pointer>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__parallel_link(const std::vector<Pointer> &sorted, size_type threads) {
+	size_type n = sorted.size();
+	if (threads > n) threads = n;
+	if (threads == 0) return;
+
+	// 每段保存各层的首节点和尾节点
+	struct segment {
+		link_type head[update_capacity];
+		link_type tail[update_capacity];
+		size_type top;
+		size_type count;
+		std::exception_ptr error;
+	};
+	std::vector<segment> segments(threads);
+	// 各线程生成随机层级时读取max_level，因此先按最终的节点数量提高层数上限，链接完成后无需再提高
+	__reserve_level(n);
+	// rand()不是线程安全的，因此预先为各线程生成随机数种子
+	std::vector<unsigned> seeds(threads);
+	for (size_type i = 0; i < threads; ++i) seeds[i] = rand();
+
+	std::vector<std::thread> workers;
+	for (size_type t = 0; t < threads; ++t) {
+		workers.push_back(std::thread([this, &sorted, &segments, &seeds, n, threads, t]() {
+			segment &seg = segments[t];
+			std::fill(seg.head, seg.head + update_capacity, link_type(nullptr));
+			std::fill(seg.tail, seg.tail + update_capacity, link_type(nullptr));
+			seg.top = 0;
+			seg.count = 0;
+			std::mt19937 gen(seeds[t]);
+			try {
+				for (size_type j = n * t / threads; j < n * (t+1) / threads; ++j) {
+					link_type node = create_node(std::move(*sorted[j]), random_level(gen));
+					for (size_type i = 0; i <= node->level; ++i) {
+						if (seg.tail[i]) __set_next(seg.tail[i], i, node);
+						else seg.head[i] = node;
+						seg.tail[i] = node;
+					}
+					if (node->level > seg.top) seg.top = node->level;
+					++seg.count;
+				}
+			} catch (...) {
+				seg.error = std::current_exception();
+			}
+		}));
+	}
+	for (auto &worker : workers) worker.join();
+
+	// 按顺序将各段在每层的首节点链接到前一段在该层的尾节点之后
+	link_type tail[update_capacity];
+	__init_tail(tail);
+	std::exception_ptr error;
+	for (size_type t = 0; t < threads; ++t) {
+		segment &seg = segments[t];
+		for (size_type i = 0; i <= seg.top; ++i) {
+			if (!seg.head[i]) continue;
+			__set_next(tail[i], i, seg.head[i]);
+			tail[i] = seg.tail[i];
+		}
+		if (seg.top > top_level) top_level = seg.top;
+		node_count += seg.count;
+		if (seg.error && !error) error = seg.error;
+	}
+	__grow();
+
+	// 若有线程创建节点失败，则释放已创建的所有节点并重新抛出异常
+	if (error) {
+		clear();
+		std::rethrow_exception(error);
+	}
+	// 各段的节点由不同线程创建，最后统一加入哈希索引
+	if (hash_index) {
+		index.reserve(node_count);
+		for (link_type x = header->forward()[0]; x; x = x->forward()[0]) index.insert(x);
+	}
+	if (deterministic) __rebalance();
+}
+
 /*
 // 将节点插入跳表中，并允许节点重复
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-typename skiplist<Key, Value, KeyOfValue, Compare>::iterator
-skiplist<Key, Value, KeyOfValue, Compare>::insert_equal(const value_type &val) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::iterator
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::insert_equal(const value_type &val) {
 #ifndef NDEBUG
 	std::cout << "call: insert_equal ";
 #endif
 	link_type current = header;
 	// 使用update来保存每层中最后一个满足其key小于待插入节点的key的节点（即前驱节点)
-	// update大小设置为max_level+1以确保有足够的空间来存放每层满足条件的节点
-	link_type update[max_level+1];
-	bzero(update, sizeof(link_type)*(max_level+1));
+	// update大小为update_capacity，在编译期确定，且足以存放每层满足条件的节点
+	// 查找会填充[0, top_level]层，__insert会填充新增的层，因此无需清零
+	link_type update[update_capacity];
 
 	// 从跳表最高层开始查找
 	for (int i = top_level; i >= 0; --i) {
 		// 若当前节点的后继不为空且后继的key小于待插入的节点的key
 		// 表明需要在当前层继续前进，继续while循环
-		while (current->forward[i] && key_compare(key(current->forward[i]), KeyOfValue()(val)))
-			current = current->forward[i];
+		while (current->forward()[i] && key_compare(key(current->forward()[i]), KeyOfValue()(val)))
+			current = current->forward()[i];
 		// 若当前节点的后继为空或后继节点的key大于等于目标节点的key
 		// 则current此时即为待插入节点的前一个位置（前驱节点），将其保存到update中
 		update[i] = current;
@@ -299,68 +1244,332 @@ skiplist<Key, Value, KeyOfValue, Compare>::insert_equal(const value_type &val) {
 */
 
 // 创建一个节点并设置相应的值以及前驱和后继，返回指向新节点的迭代器
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-typename skiplist<Key, Value, KeyOfValue, Compare>::iterator
-skiplist<Key, Value, KeyOfValue, Compare>::__insert(link_type* update, const value_type &val) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::iterator
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__insert(link_type* update, const value_type &val) {
 	// 为待插入的节点生成随机层数，层索引从0开始，所以实际层数为level+1
-	size_type level = random_level();
+	// 确定性平衡模式下新节点的层级总为0，插入后再通过提升节点来维持平衡
+	size_type level = deterministic ? 0 : random_level();
+
+	// 创建待插入的新节点，并将其链接到跳表中
+	link_type node = __link(update, create_node(val, level));
+	// 返回新节点的位置
+	return node;
+}
 
+// 将层级已确定的节点链接到跳表中，update为查找得到的各层前驱节点
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::link_type
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__link(link_type *update, link_type node) {
+	size_type level = node->level;
 	// 若待插入节点的level大于当前跳表中的最高层级top_level（不是max_level）
 	// 则表明在层级为[top_level+1, level]范围内，待插入节点的前驱必为header
 	if (level > top_level) {
 		for (size_type i = top_level+1; i <= level; ++i)
 			update[i] = header;
 		// 更新跳表的最高层级
-		top_level = level;
+		__set_top_level(level);
 	}
 
-	// 创建待插入的新节点
-	link_type node = create_node(val, level);
-
 	// 设置新节点在跳表中的前驱和后继
 	for (size_type i = 0; i <= level; ++i) {
 		// 将新节点的后继设置为事先所保存的前驱节点的后继
-		node->forward[i] = update[i]->forward[i];
+		__copy_next(node, i, update[i]);
 		// 更新事先所保存的前驱节点的后继为当前节点
-		update[i]->forward[i] = node;
+		__set_next(update[i], i, node);
 	}
 
 	// 更新跳表中的节点总数
 	++node_count;
+	index.insert(node);
+	__grow();
 
-	// 返回新节点的位置
+	// 确定性平衡模式下修复新节点所在的间隔
+	if (deterministic) __insert_fixup(update);
 	return node;
 }
 
 // 在跳表中根据key查找节点，key存在则返回指向该节点的迭代器，否则返回尾迭代器
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-typename skiplist<Key, Value, KeyOfValue, Compare>::iterator
-skiplist<Key, Value, KeyOfValue, Compare>::find(const key_type &k) const {
-	link_type current = header;
-	// 从跳表最高层开始查找
-	for (int i = top_level; i >= 0; --i) {
-		// 若当前节点的后继不为空且后继的key小于目标key
-		// 表明需要在当前层继续前进，继续while循环
-		while (current->forward[i] && key_compare(key(current->forward[i]), k))
-			current = current->forward[i];
-		// 若当前节点的后继为空或后继节点的key大于等于目标的key
-		// 表明需要向下降一层级，即结束while循环，开启下一次for循环
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::iterator
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::find(const key_type &k) const {
+	typename observer_type::trace trace(observer, skiplist_op_find);
+	// 自适应平衡模式下查找会调整节点的层级，但不改变跳表中的元素，因此在逻辑上仍是常量操作
+	// 维护哈希索引时直接通过索引查找，期望时间复杂度为O(1)
+	if (hash_index) return __index_find(k);
+	// 冻结后通过静态B+树查找，自适应平衡模式下也不再调整层级
+	if (frozen_layout) {
+		link_type x = __frozen_lower_bound(k);
+		return x && !key_compare(k, key(x)) ? x : nullptr;
 	}
-	// 当for循环结束时，表明已经查找到了第0层级
-	// 且此时的current节点必定是跳表中满足key小于目标key的所有节点中，key最大的那个节点
-	// 若key存在，则current的后继即为所要查找的目标节点
-	current = current->forward[0];
+	if (adaptive) return const_cast<skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>*>(this)->__adaptive_find(k);
+
+	// 查找结束时，前驱节点必定是跳表中满足key小于目标key的所有节点中，key最大的那个节点
+	// 若key存在，则前驱节点的后继即为所要查找的目标节点
+	link_type pred = __search(k, nullptr, trace), current = __first_not_less(pred, k);
 
 	// 若目标节点在跳表中，则直接返回其位置即可
-	if (current && !key_compare(k, key(current))) return current;
+	if (current && next_equal(pred, current, k)) return current;
 
 	// 若目标节点不在跳表中，则返回尾迭代器
 	return end();
 }
 
+// 批量查找，每个查找是一个状态机，保存当前节点、当前层和已预取的后继
+// 每一轮依次推进各个查找：比较已预取的后继，前进或下降一层，直到需要访问一个新的节点时，预取该节点并切换到下一个查找
+// 下降后的后继与下降前相同时，该节点已经读取过，继续比较而不切换；第0层的查找结束后，在该位置开始下一个key的查找
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename ForwardIterator, typename RandomAccessIterator>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::find_many(ForwardIterator first, ForwardIterator last,
+		RandomAccessIterator result) const {
+	if (hash_index || adaptive || frozen_layout) {
+		for (size_type i = 0; first != last; ++first, ++i) result[i] = find(*first);
+		return;
+	}
+
+	struct lookup {
+		ForwardIterator key;
+		size_type index;
+		probe_type probe;
+		link_type current;
+		link_type next;
+		int level;
+	};
+	lookup group[find_group];
+	size_type active = 0, index = 0;
+	// 从头节点的最高层开始一个新的查找
+	auto start = [&](lookup &s) {
+		s.key = first;
+		s.index = index++;
+		s.probe = key_cache::probe(*first);
+		++first;
+		s.current = header;
+		s.level = __top_level();
+		s.next = header->forward()[s.level];
+		__builtin_prefetch(s.next);
+	};
+	while (active < find_group && first != last) start(group[active++]);
+
+	while (active) {
+		for (size_type j = 0; j < active; ) {
+			lookup &s = group[j];
+			const key_type &k = *s.key;
+			bool done = false;
+			for (;;) {
+				// 后继的key小于目标key时前进到后继，再预取新的后继
+				if (s.next && next_less(s.current, s.next, s.level, k, s.probe)) {
+					s.current = s.next;
+					s.next = s.current->forward()[s.level];
+					break;
+				}
+				if (s.level == 0) {
+					done = true;
+					break;
+				}
+				// 下降一层，后继不变时无需等待
+				link_type next = s.current->forward()[--s.level];
+				if (next == s.next) continue;
+				s.next = next;
+				break;
+			}
+			if (!done) {
+				__builtin_prefetch(s.next);
+				++j;
+				continue;
+			}
+			// 第0层的后继的key不小于目标key，查找结束
+			link_type pred = s.current, node = __first_not_less(pred, k);
+			result[s.index] = iterator(node && next_equal(pred, node, k) ? node : nullptr);
+			if (first != last) {
+				start(s);
+				++j;
+			} else {
+				// 用最后一个查找填补空位，下一次循环处理被移动的查找
+				s = group[--active];
+			}
+		}
+	}
+}
+
+// 游标的定位，path[i]为上一次定位时第i层中最后一个key小于目标key的节点
+// 若第i层的前驱的后继不小于k，则第i层及更高各层的前驱都不需要改变（高层的后继不会比低层的后继更靠前）
+// 因此从第0层向上找到第一个这样的层h，再从第h-1层的前驱开始向下查找，上升和下降的层数均约为log(d)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::cursor::seek(const key_type &k) {
+	if (list->frozen_layout) {
+		size_type rank = list->frozen_layout->search.lower_bound(k, list->key_compare);
+		path[0] = rank ? list->__frozen_node(rank - 1) : list->header;
+		current = list->__frozen_node(rank);
+		return;
+	}
+	probe_type p = key_cache::probe(k);
+	// 目标key不大于当前前驱的key时需要后退，从header重新查找
+	if (path[0] != list->header && !list->key_less(path[0], k, p))
+		for (size_type i = 0; i < update_capacity; ++i) path[i] = list->header;
+
+	int top = list->__top_level(), h = 0;
+	for (link_type next; h <= top && (next = path[h]->forward()[h]) && list->next_less(path[h], next, h, k, p); ++h) ;
+	if (h > 0) {
+		link_type x = path[h - 1];
+		for (int i = h - 1; i >= 0; --i) {
+			link_type next = x->forward()[i];
+			while (next && list->next_less(x, next, i, k, p)) {
+				x = next;
+				next = x->forward()[i];
+			}
+			path[i] = x;
+		}
+	}
+	current = list->__first_not_less(path[0], k);
+}
+
+// 自适应平衡模式下的查找，在某一层遇到目标节点时立即返回，使位于高层的热点节点无需下降到第0层即可找到
+// 被采样时在查找路径上检查层级恰为当前层、且高于随机层级的节点，若其已冷却则将其从当前层摘除
+// 冷却的节点只有在查找经过时才会影响查找路径的长度，因此只在经过时降低即可
+// 找到目标节点后增加其访问计数，若目标层级高于当前层级，则利用更高各层的前驱将其链接到新增的层
+// 目标节点总是在其最高层被首次遇到，此时更高各层的前驱均已保存在update中
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::link_type
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__adaptive_find(const key_type &k) {
+	probe_type p = key_cache::probe(k);
+	if (!__sampled()) {
+		link_type current = header;
+		for (int i = top_level; i >= 0; --i) {
+			link_type next;
+			while ((next = current->forward()[i]) && next_less(current, next, i, k, p)) current = next;
+			if (next && key_equal(next, k)) return next;
+		}
+		return nullptr;
+	}
+
+	// 每个纪元的采样次数与节点数相当，节点较少时至少为64次
+	if (++sample_count >= std::max(node_count, size_type(64))) {
+		sample_count = 0;
+		++epoch;
+	}
+
+	link_type update[update_capacity];
+	link_type current = header, target_node = nullptr;
+	for (int i = top_level; i >= 0 && !target_node; --i) {
+		link_type next;
+		while ((next = current->forward()[i])) {
+			if (i > 0 && next->level == size_type(i) && next->level > next->base_level) {
+				__decay(next);
+				if (__target_level(next) < next->level) {
+					__copy_next(current, i, next);
+					--next->level;
+					continue;
+				}
+			}
+			if (!key_less(next, k, p)) break;
+			current = next;
+		}
+		update[i] = current;
+		if (next && key_equal(next, k)) target_node = next;
+	}
+	__trim_top_level();
+
+	current = target_node;
+	if (!current) return nullptr;
+
+	__decay(current);
+	if (current->hits < 0xffff) ++current->hits;
+	size_type level = current->level, target = __target_level(current);
+	if (target > level) {
+		__set_level(current, target);
+		for (size_type i = level+1; i <= target; ++i) {
+			link_type prev = i <= top_level ? update[i] : header;
+			__copy_next(current, i, prev);
+			__set_next(prev, i, current);
+		}
+		if (target > top_level) top_level = target;
+	}
+	return current;
+}
+
+// 利用高层的节点将key在[lo, hi)范围内的节点划分为约chunks个连续的块
+// 从最高层开始逐层向下，找到第一个在范围内的节点数不少于chunks的层，以该层的节点作为分块边界
+// 由于每下降一层节点数约增加一倍，因此各块的大小大致均衡，且无需遍历第0层
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__partition(const key_type &lo, const key_type &hi, size_type chunks, std::vector<link_type> &bounds) const {
+	bounds.clear();
+	// 冻结后按秩均分
+	if (frozen_layout) {
+		size_type first = frozen_layout->search.lower_bound(lo, key_compare);
+		size_type last = key_compare(lo, hi) ? frozen_layout->search.lower_bound(hi, key_compare) : first;
+		for (size_type i = 0; i <= chunks; ++i) bounds.push_back(__frozen_node(first + (last - first) * i / chunks));
+		return;
+	}
+	link_type update[update_capacity];
+	link_type first = __search(lo, update)->forward()[0];
+	// 范围为空时只有一个空块
+	if (!key_compare(lo, hi)) { bounds.push_back(first); bounds.push_back(first); return; }
+	link_type last = __search(hi, nullptr)->forward()[0];
+
+	bounds.push_back(first);
+	std::vector<link_type> points;
+	for (int i = top_level; i > 0; --i) {
+		points.clear();
+		for (link_type x = update[i]->forward()[i]; x && key_compare(key(x), hi); x = x->forward()[i]) points.push_back(x);
+		if (points.size() >= chunks) break;
+	}
+	for (link_type x : points) if (x != first) bounds.push_back(x);
+	bounds.push_back(last);
+}
+
+// 并行遍历key在[lo, hi)范围内的所有元素，各块作为独立的任务交由工作窃取线程池执行
+// 块的数量为线程数的4倍，使得较早完成的线程可以窃取剩余的块
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename Function>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::parallel_for_each(const key_type &lo, const key_type &hi, Function fn, const skiplist_parallel &policy) const {
+	size_type threads = policy.concurrency();
+	std::vector<link_type> bounds;
+	__partition(lo, hi, threads * 4, bounds);
+
+	__work_stealing_pool pool(threads);
+	pool.run(bounds.size() - 1, [&](size_t c) {
+		for (link_type x = bounds[c]; x != bounds[c+1]; x = x->forward()[0]) fn(value(x));
+	});
+}
+
+// 并行归约key在[lo, hi)范围内的所有元素，各块的结果按key的顺序合并
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename T, typename BinaryOperation, typename Combine>
+T skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::parallel_reduce(const key_type &lo, const key_type &hi, T init, BinaryOperation op, Combine combine,
+		const skiplist_parallel &policy) const {
+	size_type threads = policy.concurrency();
+	std::vector<link_type> bounds;
+	__partition(lo, hi, threads * 4, bounds);
+
+	std::vector<T> partial(bounds.size() - 1, init);
+	__work_stealing_pool pool(threads);
+	pool.run(bounds.size() - 1, [&](size_t c) {
+		T acc = init;
+		for (link_type x = bounds[c]; x != bounds[c+1]; x = x->forward()[0]) acc = op(acc, value(x));
+		partial[c] = acc;
+	});
+
+	for (size_type c = 0; c < partial.size(); ++c) init = combine(init, partial[c]);
+	return init;
+}
+
 // 将一对迭代器[first, last)表示的范围内的节点从跳表中删除
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-void skiplist<Key, Value, KeyOfValue, Compare>::erase(const_iterator first, const_iterator last) {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::erase(const_iterator first, const_iterator last) {
+	if (first == last) return;
+	// 已冻结时解冻会使迭代器失效，先记下范围两端的key，解冻后再重新定位
+	if (frozen_layout) {
+		key_type lo = KeyOfValue()(*first);
+		if (last == cend()) {
+			thaw();
+			erase(lower_bound(lo), cend());
+		} else {
+			key_type hi = KeyOfValue()(*last);
+			thaw();
+			erase(lower_bound(lo), lower_bound(hi));
+		}
+		return;
+	}
 	while (first != last) {
 		key_type tmp = KeyOfValue()(*first);
 		++first;
@@ -368,71 +1577,677 @@ void skiplist<Key, Value, KeyOfValue, Compare>::erase(const_iterator first, cons
 	}
 }
 
+// 删除key最小的元素，直接将首节点从其所在的每一层摘除
+// 确定性平衡模式下首节点必在第0层的第一个间隔中，层级为0，摘除后从该间隔开始向上修复，各层的左边界均为header
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::pop_front() {
+	thaw();
+	link_type node = header->forward()[0];
+	for (size_type i = 0; i <= node->level; ++i) __copy_next(header, i, node);
+	--node_count;
+	index.erase(node);
+	if (deterministic) {
+		link_type update[update_capacity];
+		for (size_type i = 0; i <= top_level; ++i) update[i] = header;
+		__erase_fixup(update);
+	} else {
+		__trim_top_level();
+	}
+	__dispose(node);
+}
+
 // 在跳表中根据key删除节点
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-void skiplist<Key, Value, KeyOfValue, Compare>::__erase(const key_type &k) {
-	link_type current = header;
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__erase(const key_type &k) {
+	typename observer_type::trace trace(observer, skiplist_op_erase);
+	link_type current = __unlink(k, trace);
+	// 若待删除的key对应的节点在跳表中，则释放节点所占用的内存空间
+	if (current) {
+		__dispose(current);
+	}
+}
 
+// 将key对应的节点从跳表中摘除但不销毁，返回被摘除的节点，key不存在时返回空
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+template <typename Trace>
+typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::link_type
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__unlink(const key_type &k, Trace &trace) {
 	// 使用update来保存每层中最后一个满足其key小于待删除节点的key的节点（即前驱节点）
-	// update大小设置为max_level+1以确保有足够的空间来存放每层满足条件的节点
-	link_type update[max_level+1];
-	bzero(update, sizeof(link_type)*(max_level+1));
+	// update大小为update_capacity，在编译期确定，且足以存放每层满足条件的节点
+	// 查找会填充[0, top_level]层，__insert会填充新增的层，因此无需清零
+	link_type update[update_capacity];
 
-	// 从跳表最高层开始查找
+	// 查找到第0层的前驱节点后
+	// current->forward()[0]的key此时可能等于或大于待删除节点的key
+	link_type pred = __search(k, update, trace), current = pred->forward()[0];
+	if (!current || !next_equal(pred, current, k)) return nullptr;
+	index.erase(current);
+
+	// 确定性平衡模式下删除节点需要维持各层间隔的大小
+	if (deterministic) {
+		size_type level = current->level;
+		if (level > 0) {
+			// 待删除节点是高层节点时，由其在第0层的前驱（必为层级为0的节点）代替它在[1, level]层的位置
+			// 相当于B树中用前驱key替换内部节点的key，之后只需修复前驱原先所在的第0层间隔
+			link_type prev = update[0];
+			__set_level(prev, level);
+			for (size_type i = 1; i <= level; ++i) {
+				__copy_next(prev, i, current);
+				__set_next(update[i], i, prev);
+			}
+		}
+		__copy_next(update[0], 0, current);
+		--node_count;
+		__erase_fixup(update);
+		return current;
+	}
+
+	// 从第0层开始修改前驱和后继
+	for (size_type i = 0; i <= top_level; ++i) {
+		// 若前驱的后继不再是待删除的节点，则退出循环
+		if (update[i]->forward()[i] != current) break;
+		// 将前驱的后继修改为待删除节点的后继
+		__copy_next(update[i], i, current);
+	}
+
+	// 由于删除的节点的层级可能为当前跳表的唯一最大层
+	// 因此删除节点后，需要更新当前跳表的最大层级
+	// 若头节点在最高层的后继为空，则表明最高层为空，需要降低最高层
+	__trim_top_level();
+
+	// 更新跳表中的节点总数
+	--node_count;
+	return current;
+}
+
+// 插入节点句柄所拥有的节点，直接链接原有节点而不重新分配
+// 随机平衡模式下沿用节点原有的层级，确定性平衡模式下从第0层开始重新平衡，自适应平衡模式下恢复为随机生成的层级
+// 句柄中的key被修改后，若key缓存所需的空间超出节点原有的空间，则将元素移动到重新分配的节点中
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+typename skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::insert_return_type
+skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::insert_unique(node_type &&nh) {
+	insert_return_type result = { end(), false, node_type() };
+	if (nh.empty()) return result;
+	thaw();
+	__own_header();
+
+	link_type update[update_capacity];
+	const key_type &k = key(nh.node);
+	if (hash_index) {
+		link_type node = __index_find(k);
+		if (node) {
+			result.position = node;
+			result.node = std::move(nh);
+			return result;
+		}
+	}
+	link_type pred = __search(k, update), current = pred->forward()[0];
+	// 若key已经存在于跳表中，则插入失败，将节点交还给调用者
+	if (current && next_equal(pred, current, k)) {
+		result.position = current;
+		result.node = std::move(nh);
+		return result;
+	}
+
+	link_type node = nh.node;
+	if (cache_bytes(k) > nh.cache_size) {
+		node = create_node(std::move(value(nh.node)), nh.node->level);
+		node->base_level = nh.node->base_level;
+		destroy_node(nh.node);
+	} else {
+		key_cache::construct(node->cache(), k);
+	}
+	nh.node = nullptr;
+
+	if (deterministic) {
+		node->level = 0;
+	} else if (adaptive) {
+		node->level = node->base_level;
+		node->hits = 0;
+		node->stamp = epoch;
+	}
+	// 节点可能来自层数上限更大的跳表
+	if (node->level > max_level) node->level = max_level;
+
+	result.position = __link(update, node);
+	result.inserted = true;
+	return result;
+}
+
+// 确定性平衡模式下插入节点后，自底向上修复节点过多的间隔
+// 第i层的间隔是指第i+1层中相邻两个节点（包括header和链表末尾）之间、层级恰为i的节点
+// 1-2-3跳表要求每个间隔的大小在[1, 3]范围内，新插入的节点层级为0，可能使其所在的间隔增大到4
+// 此时提升间隔中的第2个节点，将间隔拆分为大小为1和2的两个间隔，被提升的节点又使上一层的间隔增大，依次向上修复
+// 新节点在第i层所在间隔的左边界即为第i+1层的前驱update[i+1]
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__insert_fixup(link_type *update) {
+	for (size_type i = 0; i < max_level; ++i) {
+		link_type left = i+1 <= top_level ? update[i+1] : header;
+		link_type right = left->forward()[i+1];
+		size_type count = 0;
+		for (link_type x = left->forward()[i]; x != right; x = x->forward()[i]) ++count;
+		if (count <= 3) return;
+
+		link_type middle = left->forward()[i]->forward()[i];
+		__set_level(middle, i+1);
+		__set_next(middle, i+1, right);
+		__set_next(left, i+1, middle);
+		if (i+1 > top_level) top_level = i+1;
+	}
+}
+
+// 确定性平衡模式下删除节点后，自底向上修复节点过少（为空）的间隔，与B树的删除类似
+// 若右侧相邻间隔（分隔节点的层级恰为i+1）至少有2个节点，则降低分隔节点并提升右侧间隔的首节点（借用）
+// 否则只降低分隔节点，使两个间隔合并（合并），上一层的间隔因此减少一个节点，需要继续向上修复
+// 右侧没有同一父间隔内的相邻间隔时，对左侧相邻间隔进行对称的操作
+// 被修改的间隔在第i层的左边界总是update[i+1]
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__erase_fixup(link_type *update) {
+	for (size_type i = 0; i < top_level; ++i) {
+		link_type left = update[i+1];
+		link_type right = left->forward()[i+1];
+		// 间隔不为空，无需修复
+		if (left->forward()[i] != right) break;
+
+		if (right && right->level == i+1) {
+			link_type next = right->forward()[i+1];
+			link_type first = right->forward()[i];
+			// 降低右侧的分隔节点
+			__set_next(left, i+1, next);
+			right->level = i;
+			// 右侧相邻间隔至少有2个节点时，提升其首节点作为新的分隔节点
+			if (first->forward()[i] != next) {
+				__set_level(first, i+1);
+				__set_next(first, i+1, next);
+				__set_next(left, i+1, first);
+				break;
+			}
+		} else if (left != header && left->level == i+1) {
+			// 查找左侧分隔节点（即left）在第i+1层的前驱，由于间隔的大小有上界，因此只需常数步
+			link_type prev = i+2 <= top_level ? update[i+2] : header;
+			while (prev->forward()[i+1] != left) prev = prev->forward()[i+1];
+			// 查找左侧相邻间隔的最后一个节点，并统计其节点数
+			link_type last = prev;
+			size_type count = 0;
+			for (link_type x = prev->forward()[i]; x != left; x = x->forward()[i]) { last = x; ++count; }
+			// 降低左侧的分隔节点
+			__set_next(prev, i+1, right);
+			left->level = i;
+			// 左侧相邻间隔至少有2个节点时，提升其最后一个节点作为新的分隔节点
+			if (count >= 2) {
+				__set_level(last, i+1);
+				__set_next(last, i+1, right);
+				__set_next(prev, i+1, last);
+				break;
+			}
+		} else {
+			break;
+		}
+	}
+	// 最高层的间隔为空时降低最高层
+	__trim_top_level();
+}
+
+// 确定性平衡模式下，按节点的顺序重新分配所有节点的层级
+// 自底向上逐层将节点分组，每组1~3个（尽量为2个），组与组之间的节点被提升到上一层，直到最高层不超过3个节点
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__rebalance() {
+	std::vector<link_type> nodes;
+	nodes.reserve(node_count);
+	for (link_type x = header->forward()[0]; x; x = x->forward()[0]) {
+		nodes.push_back(x);
+		x->level = 0;
+	}
+
+	std::vector<link_type> items(nodes), separators;
+	for (size_type level = 1; level <= max_level && items.size() > 3; ++level) {
+		// m个节点分为g组，g-1个分隔节点，每组的大小在[1, 3]范围内
+		size_type m = items.size(), groups = (m + 1 + 2) / 3;
+		size_type members = m - (groups - 1);
+		separators.clear();
+		size_type pos = 0;
+		for (size_type g = 0; g + 1 < groups; ++g) {
+			pos += members / groups + (g < members % groups ? 1 : 0);
+			separators.push_back(items[pos]);
+			++pos;
+		}
+		for (link_type x : separators) __set_level(x, level);
+		items.swap(separators);
+	}
+
+	__detach();
+	link_type tail[update_capacity];
+	__init_tail(tail);
+	for (link_type x : nodes) __append(tail, x);
+}
+
+// 按rhs的节点结构复制所有节点，要求当前跳表为空，rhs已冻结时按冻结前的层级创建节点
+// 同时遍历rhs的第0层，以相同的层级创建节点并追加到末尾，每个节点只需O(level)的时间，因此总时间复杂度为O(n)
+// 复制后各层的链接与rhs完全相同，不会因为重新生成随机层级而改变查找性能
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__clone(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs) {
+	link_type tail[update_capacity];
+	__init_tail(tail);
+	for (link_type x = rhs.header->forward()[0]; x; x = x->forward()[0]) {
+		link_type node = create_node(value(x), rhs.frozen_layout ? x->base_level : x->level);
+		node->base_level = x->base_level;
+		node->stamp = x->stamp;
+		node->hits = x->hits;
+		__append(tail, node);
+	}
+	sample_count = rhs.sample_count;
+	epoch = rhs.epoch;
+}
+
+// 将节点x重新分配到连续的内存中，新节点的层级、访问计数和各层的后继与x相同
+// 元素能无异常地移动时从x移动，否则复制；单写多读模式下读者可能仍在访问x，因此总是复制
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__relocate(link_type x, link_type *update) {
+	typedef typename std::conditional<concurrent, const value_type&,
+			decltype(std::move_if_noexcept(std::declval<value_type&>()))>::type source_type;
+	link_type node = create_node(static_cast<source_type>(value(x)), x->level, true);
+	node->base_level = x->base_level;
+	node->stamp = x->stamp;
+	node->hits = x->hits;
+	for (size_type i = 0; i <= x->level; ++i) {
+		__copy_next(node, i, x);
+		__set_next(update[i], i, node);
+		update[i] = node;
+	}
+	index.replace(x, node);
+	__dispose(x);
+}
+
+// 增量整理，沿第0层按key的顺序重新分配节点，同时维护每层最后一个已处理的节点作为前驱，每个节点只需O(level)的时间
+// 继续上次的整理时，先查找上次最后移动的节点的各层前驱，该节点所在的各层中前驱即为该节点本身
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+bool skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::compact(size_type steps) {
+	if (frozen_layout) return true;
+	link_type update[update_capacity];
+	__init_tail(update);
+	link_type x = header->forward()[0];
+	if (compact_resume) {
+		x = __search(*compact_resume, update)->forward()[0];
+		if (x && key_equal(x, *compact_resume)) {
+			for (size_type i = 0; i <= x->level; ++i) update[i] = x;
+			x = x->forward()[0];
+		}
+	}
+
+	for (; x && steps; --steps) {
+		link_type next = x->forward()[0];
+		__relocate(x, update);
+		x = next;
+	}
+
+	if (!x) {
+		compact_resume.reset();
+		return true;
+	}
+	if (update[0] != header) compact_resume.reset(new key_type(key(update[0])));
+	return false;
+}
+
+// 冻结：先复制所有key建立静态B+树，再按key的顺序将元素移动（移动可能抛出异常时复制）到连续的节点数组中
+// 建立索引和构造节点都可能抛出异常，此时原有的节点保持不变：可能抛出异常的构造只会复制元素
+// 全部完成后才销毁原有的节点，header只保留第0层的链接
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::freeze() {
+	if (frozen_layout) return;
+	__own_header();
+	reclaim();
+	compact_resume.reset();
+	typedef decltype(std::move_if_noexcept(std::declval<value_type&>())) source_type;
+
+	std::unique_ptr<frozen_type> layout(new frozen_type);
+	// 节点只有一个forward元素，不含key缓存，按节点分配器要求的粒度对齐
+	size_type align = compact_links ? __skiplist_node_pool<skiplist_node>::granule : alignof(skiplist_node);
+	layout->stride = (sizeof(skiplist_node) + sizeof(link_slot) + align - 1) / align * align;
+	layout->per_array = 0;
+	size_type rank = 0;
+	try {
+		layout->search.reserve(node_count);
+		for (link_type x = header->forward()[0]; x; x = x->forward()[0]) layout->search.push_back(key(x));
+		layout->search.build();
+		for (size_type remaining = node_count; remaining; ) {
+			size_type count = remaining;
+			layout->arrays.push_back(typename frozen_type::array{nullptr, 0});
+			layout->arrays.back().base = static_cast<char*>(node_allocator::allocate_array(layout->stride, count));
+			layout->arrays.back().count = count;
+			if (!layout->per_array) layout->per_array = count;
+			remaining -= count;
+		}
+		link_type prev = nullptr;
+		for (link_type x = header->forward()[0]; x; x = x->forward()[0], ++rank) {
+			link_type node = layout->node(rank);
+			link_slot *forward = reinterpret_cast<link_slot*>(reinterpret_cast<char*>(node) + sizeof(skiplist_node));
+			new (node) skiplist_node(static_cast<source_type>(value(x)), 0, 1, forward);
+			// 保留冻结前的随机层级和访问计数，解冻时据此恢复
+			node->base_level = x->base_level;
+			node->stamp = x->stamp;
+			node->hits = x->hits;
+			if (prev) prev->forward()[0] = node;
+			prev = node;
+		}
+	} catch (...) {
+		__destroy_frozen(*layout, rank);
+		throw;
+	}
+
+	rank = 0;
+	for (link_type x = header->forward()[0]; x; ++rank) {
+		link_type next = x->forward()[0];
+		index.replace(x, layout->node(rank));
+		destroy_node(x);
+		x = next;
+	}
+	bzero(header->forward(), sizeof(link_slot)*(top_level+1));
+	header->forward()[0] = node_count ? layout->node(0) : nullptr;
+	__set_top_level(0);
+	frozen_layout = std::move(layout);
+}
+
+// 解冻：以冻结前的随机层级（确定性平衡模式下为0，之后重新分配层级）重新创建节点，按key的顺序追加到跳表中
+// 创建节点时抛出异常则将已移动的元素移回冻结的节点，跳表仍保持冻结
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::thaw() {
+	if (!frozen_layout) return;
+	typedef decltype(std::move_if_noexcept(std::declval<value_type&>())) source_type;
+
+	std::vector<link_type> nodes;
+	nodes.reserve(node_count);
+	link_type first = header->forward()[0];
+	try {
+		for (link_type x = first; x; x = x->forward()[0]) {
+			link_type node = create_node(static_cast<source_type>(value(x)), x->base_level);
+			node->base_level = x->base_level;
+			node->stamp = x->stamp;
+			node->hits = x->hits;
+			nodes.push_back(node);
+		}
+	} catch (...) {
+		link_type x = first;
+		for (link_type node : nodes) {
+			if (std::is_rvalue_reference<source_type>::value) {
+				x->value_field.~value_type();
+				new (&x->value_field) value_type(std::move(value(node)));
+			}
+			destroy_node(node);
+			x = x->forward()[0];
+		}
+		throw;
+	}
+
+	std::unique_ptr<frozen_type> layout(std::move(frozen_layout));
+	size_type n = node_count;
+	__detach();
+	link_type tail[update_capacity];
+	__init_tail(tail);
+	for (link_type node : nodes) __append(tail, node);
+	if (deterministic) __rebalance();
+	__destroy_frozen(*layout, n);
+}
+
+// 析构冻结的前constructed个节点，并将所有节点数组归还给节点分配器
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__destroy_frozen(frozen_type &layout, size_type constructed) {
+	for (size_type rank = 0; rank < constructed; ++rank) layout.node(rank)->~skiplist_node();
+	for (const typename frozen_type::array &a : layout.arrays)
+		if (a.base) node_allocator::deallocate_array(a.base, layout.stride, a.count);
+	layout.arrays.clear();
+}
+
+// 将节点追加到跳表末尾，tail保存每层的最后一个节点
+// 节点的key必须大于跳表中所有节点的key，每层只需修改最后一个节点的后继，因此时间复杂度为O(level)
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__append(link_type *tail, link_type node) {
+	for (size_type i = 0; i <= node->level; ++i) {
+		node->forward()[i] = nullptr;
+		__set_next(tail[i], i, node);
+		tail[i] = node;
+	}
+	if (node->level > top_level) top_level = node->level;
+	++node_count;
+	index.insert(node);
+	__grow();
+}
+
+// 断开所有节点与header的链接，使跳表为空，但不销毁节点
+// 调用者需事先保存第0层的首节点，再通过__append重新链接需要保留的节点
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__detach() {
+	if (__owns_header()) bzero(header->forward(), sizeof(link_slot)*(top_level+1));
+	top_level = 0;
+	node_count = 0;
+	index.clear();
+}
+
+// 将rhs中key不存在于当前跳表的节点转移到当前跳表中，key重复的节点仍保留在rhs中
+// 同时遍历两个跳表的第0层，按key递增的顺序将节点重新追加到对应的跳表中
+// 节点保留原有的层级（超出当前跳表的层数上限时截断），因此无需重新分配节点
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::merge(skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs) {
+	if (this == &rhs || rhs.empty()) return;
+	thaw();
+	rhs.thaw();
+	__own_header();
+	// 提高层数上限，使rhs的节点无需截断层级
+	__raise_level(rhs.max_level);
+
+	link_type lhs_current = header->forward()[0];
+	link_type rhs_current = rhs.header->forward()[0];
+	__detach();
+	rhs.__detach();
+
+	link_type tail[update_capacity], rhs_tail[update_capacity];
+	__init_tail(tail);
+	rhs.__init_tail(rhs_tail);
+
+	while (lhs_current || rhs_current) {
+		// 追加节点会修改其forward数组，因此需要先保存第0层的后继
+		if (!rhs_current || (lhs_current && key_compare(key(lhs_current), key(rhs_current)))) {
+			link_type next = lhs_current->forward()[0];
+			__append(tail, lhs_current);
+			lhs_current = next;
+		} else if (!lhs_current || key_compare(key(rhs_current), key(lhs_current))) {
+			link_type next = rhs_current->forward()[0];
+			if (rhs_current->level > max_level) rhs_current->level = max_level;
+			__append(tail, rhs_current);
+			rhs_current = next;
+		} else {
+			// key相同时，两个节点分别留在原来的跳表中
+			link_type lhs_next = lhs_current->forward()[0];
+			link_type rhs_next = rhs_current->forward()[0];
+			__append(tail, lhs_current);
+			rhs.__append(rhs_tail, rhs_current);
+			lhs_current = lhs_next;
+			rhs_current = rhs_next;
+		}
+	}
+	if (deterministic) {
+		__rebalance();
+		rhs.__rebalance();
+	}
+}
+
+// 查找每层的最后一个节点，保存到tail中，未使用的层为header
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__last_path(link_type *tail) const {
+	link_type current = header;
+	for (size_type i = level_limit(); i > top_level; --i) tail[i] = header;
 	for (int i = top_level; i >= 0; --i) {
-		// 若当前节点的后继不为空且后继的key小于目标key
-		// 表明需要在当前层继续前进，即继续while循环
-		while (current->forward[i] && key_compare(key(current->forward[i]), k))
-			current = current->forward[i];
-		// 若当前节点的后继为空或后继节点的key大于等于目标节点的key
-		// 则current此时即为待删除节点的前一个位置（前驱节点），将其保存到update中
-		update[i] = current;
+		while (current->forward()[i]) current = current->forward()[i];
+		tail[i] = current;
 	}
+}
 
-	// 当for循环结束时，表明已经查到了第0层
-	// 那么current->forward[0]的key此时可能等于或大于待删除节点的key
-	current = current->forward[0];
+// 拆分操作，将key大于等于k的所有节点转移到result中
+// 查找路径上每层的前驱节点即为左半部分在该层的最后一个节点，切断其后继并将后继作为result在该层的首节点
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::split(const key_type &k, skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &result) {
+	if (this == &result) return;
+	if (frozen_layout) {
+		key_type tmp(k);
+		thaw();
+		split(tmp, result);
+		return;
+	}
+	result.clear();
+	__own_header();
+	result.__own_header();
+	result.__raise_level(max_level);
 
-	// 若待删除的key对应的节点在跳表中，则修改前驱和后继
-	if (current && !key_compare(k, key(current))) {
-		// 从第0层开始修改
-		for (size_type i = 0; i <= top_level; ++i) {
-			// 若前驱的后继不再是待删除的节点，则退出循环
-			if (update[i]->forward[i] != current) break;
-			// 将前驱的后继修改为待删除节点的后继
-			update[i]->forward[i] = current->forward[i];
+	link_type update[update_capacity];
+	__search(k, update);
+	// result的层数上限可能小于当前跳表，超出部分的节点需要截断层级
+	size_type limit = result.level_limit() < top_level ? result.level_limit() : top_level;
+	for (size_type i = 0; i <= top_level; ++i) {
+		link_type first = update[i]->forward()[i];
+		update[i]->forward()[i] = nullptr;
+		if (i <= limit) {
+			__set_next(result.header, i, first);
+			if (first) result.top_level = i;
+		} else {
+			for (; first; first = first->forward()[i]) if (first->level > limit) first->level = limit;
 		}
+	}
+	__trim_top_level();
 
-		// 释放节点所占用的内存空间
-		destroy_node(current);
+	// 同时从两部分的首节点开始遍历第0层，只需遍历到较短的一侧结束即可得到两侧的节点数量
+	size_type count = 0;
+	link_type lhs_current = header->forward()[0], rhs_current = result.header->forward()[0];
+	while (lhs_current && rhs_current) {
+		lhs_current = lhs_current->forward()[0];
+		rhs_current = rhs_current->forward()[0];
+		++count;
+	}
+	size_type lhs_count = lhs_current ? node_count - count : count;
+	result.node_count = node_count - lhs_count;
+	node_count = lhs_count;
 
-		// 由于删除的节点的层级可能为当前跳表的唯一最大层
-		// 因此删除节点后，需要更新当前跳表的最大层级
-		// 若头节点在最高层的后继为空，则表明最高层为空，需要降低最高层
-		while (top_level > 0 && !header->forward[top_level]) --top_level;
-		
-		// 更新跳表中的节点总数
-		--node_count;
+	// 维护哈希索引时，将较短一侧的节点移到result的索引中，必要时先交换两侧的索引，使开销与统计节点数量的开销相当
+	if (hash_index) {
+		if (lhs_current) {
+			for (link_type x = result.header->forward()[0]; x; x = x->forward()[0]) { index.erase(x); result.index.insert(x); }
+		} else {
+			index.swap(result.index);
+			for (link_type x = header->forward()[0]; x; x = x->forward()[0]) { result.index.erase(x); index.insert(x); }
+		}
+	}
+
+	// 切断链接后两侧边界处的间隔可能为空，确定性平衡模式下需要重新分配层级
+	if (deterministic) {
+		__rebalance();
+		result.__rebalance();
 	}
 }
 
+// 连接操作，将rhs的所有节点连接到当前跳表的末尾，要求rhs中的key均大于当前跳表中的key
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::join(skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs) {
+	if (this == &rhs || rhs.empty()) return;
+	thaw();
+	rhs.thaw();
+	__own_header();
+
+	__raise_level(rhs.max_level);
+	link_type tail[update_capacity];
+	__last_path(tail);
+	// 当前跳表的最后一个节点的key必须小于rhs的首节点的key，否则退化为merge
+	if (tail[0] != header && !key_compare(key(tail[0]), key(rhs.header->forward()[0]))) {
+		merge(rhs);
+		return;
+	}
+
+	size_type limit = level_limit();
+	for (size_type i = 0; i <= rhs.top_level; ++i) {
+		link_type first = rhs.header->forward()[i];
+		if (i <= limit) {
+			__set_next(tail[i], i, first);
+			if (first && i > top_level) top_level = i;
+		} else {
+			// 当前跳表的层数上限小于rhs时，截断超出部分的节点的层级
+			for (; first; first = first->forward()[i]) if (first->level > limit) first->level = limit;
+		}
+	}
+	// 维护哈希索引时，将节点较少一侧的节点加入另一侧的索引，并保留后者作为连接后的索引
+	if (hash_index) {
+		link_type rhs_first = rhs.header->forward()[0];
+		if (rhs.node_count <= node_count) {
+			for (link_type x = rhs_first; x; x = x->forward()[0]) index.insert(x);
+		} else {
+			index.swap(rhs.index);
+			for (link_type x = header->forward()[0]; x != rhs_first; x = x->forward()[0]) index.insert(x);
+		}
+	}
+	node_count += rhs.node_count;
+	__grow();
+	rhs.__detach();
+	if (deterministic) __rebalance();
+}
+
+// 以线性时间进行集合运算，同时遍历两个跳表的第0层，将需要保留的元素复制为新节点并追加到result中
+// 先在临时跳表中构造结果再与result交换，因此result可以是当前跳表或rhs本身
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::__set_operation(const skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &rhs,
+		skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> &result, bool keep_left, bool keep_both, bool keep_right) const {
+	skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy> tmp(result.max_level, result.key_compare);
+	link_type tail[update_capacity];
+	tmp.__init_tail(tail);
+
+	link_type lhs_current = header->forward()[0];
+	link_type rhs_current = rhs.header->forward()[0];
+	while (lhs_current && rhs_current) {
+		if (key_compare(key(lhs_current), key(rhs_current))) {
+			if (keep_left) tmp.__append(tail, tmp.create_node(value(lhs_current), tmp.random_level()));
+			lhs_current = lhs_current->forward()[0];
+		} else if (key_compare(key(rhs_current), key(lhs_current))) {
+			if (keep_right) tmp.__append(tail, tmp.create_node(value(rhs_current), tmp.random_level()));
+			rhs_current = rhs_current->forward()[0];
+		} else {
+			if (keep_both) tmp.__append(tail, tmp.create_node(value(lhs_current), tmp.random_level()));
+			lhs_current = lhs_current->forward()[0];
+			rhs_current = rhs_current->forward()[0];
+		}
+	}
+	for (; keep_left && lhs_current; lhs_current = lhs_current->forward()[0])
+		tmp.__append(tail, tmp.create_node(value(lhs_current), tmp.random_level()));
+	for (; keep_right && rhs_current; rhs_current = rhs_current->forward()[0])
+		tmp.__append(tail, tmp.create_node(value(rhs_current), tmp.random_level()));
+	if (deterministic) tmp.__rebalance();
+
+	result.swap(tmp);
+}
+
 // 清空跳表，释放跳表中除header外的所有节点
-template <typename Key, typename Value, typename KeyOfValue, typename Compare>
-void skiplist<Key, Value, KeyOfValue, Compare>::clear() {
+template <typename Key, typename Value, typename KeyOfValue, typename Compare, size_t MaxLevel, typename Policy>
+void skiplist<Key, Value, KeyOfValue, Compare, MaxLevel, Policy>::clear() {
+	reclaim();
+	compact_resume.reset();
+	// 冻结的节点随节点数组一起释放
+	if (frozen_layout) {
+		__destroy_frozen(*frozen_layout, node_count);
+		frozen_layout.reset();
+		header->forward()[0] = nullptr;
+		node_count = 0;
+		index.clear();
+		return;
+	}
 	// 从第0层的头节点的后继开始
-	link_type node = header->forward[0];
+	link_type node = header->forward()[0];
 	while (node) {
 		link_type tmp = node;
-		node = node->forward[0];
+		node = node->forward()[0];
 		// 销毁节点
 		destroy_node(tmp);
 	}
 
-	// 重新初始化header的forward数组
-	bzero(header->forward, sizeof(link_type)*(top_level+1));
+	// 重新初始化header的forward数组，共用的空header各层本来就为空
+	if (__owns_header()) bzero(header->forward(), sizeof(link_slot)*(top_level+1));
 	// 重置最高层级和节点数量
 	top_level = 0;
 	node_count = 0;
+	index.clear();
 }
 
 #endif
@@ -0,0 +1,92 @@
+#ifndef SKIPLIST_FROZEN_INDEX_H
+#define SKIPLIST_FROZEN_INDEX_H
+
+#include <cstddef>
+#include <vector>
+#include "skiplist_search.h"
+
+// 冻结的跳表使用的静态B+树，将key映射到其在有序序列中的位置（秩）
+// 最底层为按顺序存放的全部key，每block_size个key为一块，每块按缓存行对齐；上一层的第i个key为下一层第i块的最大key
+// 最后一块不足时用序列中最大的key填充，因此每块总是比较block_size次，比较的结果直接累加为计数，查找循环中没有数据相关的分支
+// 整数等小key的一块恰为一个缓存行（64字节），每层只访问一个缓存行，层数为log(n)/log(block_size)
+template <typename Key, typename Compare>
+class __skiplist_frozen_index {
+	public:
+		typedef size_t size_type;
+		static const size_type block_size = sizeof(Key) <= 16 ? 64 / sizeof(Key) : 8;
+
+	private:
+		struct alignas(64) block {
+			Key keys[block_size];
+		};
+
+		// levels[0]为最底层，最高层只有一块
+		std::vector<std::vector<block>> levels;
+		size_type count;
+		size_type filled;
+
+		// 统计一块中小于k的key的数量
+		// 使用std::less比较时交给__simd_count_less，32位和64位整数key在开启SSE4.2/AVX2时一次比较多个key
+		template <typename C>
+		static size_type count_less(const Key *keys, const Key &k, const C &comp) {
+			size_type c = 0;
+			for (size_type i = 0; i < block_size; ++i) c += comp(keys[i], k);
+			return c;
+		}
+		static size_type count_less(const Key *keys, const Key &k, const std::less<Key>&) {
+			return __simd_count_less(keys, block_size, k);
+		}
+
+	public:
+		__skiplist_frozen_index() : count(0), filled(0) {}
+
+		// 预留n个key的空间，之后按递增的顺序调用push_back加入所有key，最后调用build建立上层
+		void reserve(size_type n) {
+			levels.assign(1, std::vector<block>());
+			levels[0].reserve((n + block_size - 1) / block_size);
+		}
+		void push_back(const Key &k) {
+			if (filled == 0) levels[0].emplace_back();
+			levels[0].back().keys[filled] = k;
+			filled = (filled + 1) % block_size;
+			++count;
+		}
+		void build() {
+			if (!count) {
+				levels.clear();
+				return;
+			}
+			// 用最大的key填充最后一块
+			for (size_type i = filled; filled && i < block_size; ++i)
+				levels[0].back().keys[i] = levels[0].back().keys[filled - 1];
+			filled = 0;
+			while (levels.back().size() > 1) {
+				const std::vector<block> &lower = levels.back();
+				std::vector<block> upper((lower.size() + block_size - 1) / block_size);
+				for (size_type i = 0; i < upper.size() * block_size; ++i)
+					upper[i / block_size].keys[i % block_size] = lower[i < lower.size() ? i : lower.size() - 1].keys[block_size - 1];
+				levels.push_back(std::move(upper));
+			}
+		}
+
+		// 第一个不小于k的key的秩，所有key均小于k时返回key的数量
+		// 上层选中的块的最大key不小于k，因此只有最高层的计数可能达到block_size，此时所有key均小于k
+		size_type lower_bound(const Key &k, const Compare &comp) const {
+			size_type b = 0;
+			for (size_type l = levels.size(); l-- > 0; ) {
+				b = b * block_size + count_less(levels[l][b].keys, k, comp);
+				if (l > 0 && b >= levels[l - 1].size()) return count;
+			}
+			return b < count ? b : count;
+		}
+
+		size_type size() const { return count; }
+		// 索引占用的字节数
+		size_type bytes() const {
+			size_type n = 0;
+			for (const std::vector<block> &level : levels) n += level.size() * sizeof(block);
+			return n;
+		}
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef SKIPLIST_HASH_INDEX_H
+#define SKIPLIST_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// 不使用哈希索引时的空实现，所有操作均为空操作，编译后不产生任何代码
+template <typename Node>
+struct __skiplist_no_index {
+	template <typename Key, typename Equal>
+	Node* find(const Key&, Equal) const { return nullptr; }
+	void insert(Node*) {}
+	void erase(Node*) {}
+	void replace(Node*, Node*) {}
+	void clear() {}
+	void reserve(size_t) {}
+	void swap(__skiplist_no_index&) {}
+};
+
+// 开放寻址（线性探测）的哈希索引，将key映射到跳表中的节点，使按key查找的期望时间复杂度为O(1)
+// 每个槽保存节点指针和key的哈希值，探测时先比较哈希值，只有哈希值相同时才比较key
+// 删除时将后续的元素向前移位（后向移位删除），不留下墓碑，因此探测长度不会随删除而增长
+// 装载因子不超过1/2，超过时容量加倍
+template <typename Node, typename Key, typename KeyOfValue, typename Hash>
+class __skiplist_hash_index {
+	private:
+		struct slot {
+			size_t hash;
+			Node *node;
+		};
+
+		std::vector<slot> slots;
+		size_t count;
+		Hash hasher;
+
+		// 对哈希值再次散列，避免std::hash对整数为恒等映射时，规律的key在线性探测中产生聚集
+		static size_t mix(size_t h) {
+			h *= size_t(0x9E3779B97F4A7C15ull);
+			return h ^ (h >> (sizeof(size_t) * 4));
+		}
+		static const Key& key(const Node *node) { return KeyOfValue()(node->value_field); }
+		size_t mask() const { return slots.size() - 1; }
+
+		// 重新分配capacity个槽（必须为2的幂），并将所有节点重新放入
+		void rehash(size_t capacity) {
+			std::vector<slot> old(capacity, slot{0, nullptr});
+			old.swap(slots);
+			for (const slot &s : old) {
+				if (!s.node) continue;
+				size_t i = s.hash & mask();
+				while (slots[i].node) i = (i + 1) & mask();
+				slots[i] = s;
+			}
+		}
+
+	public:
+		__skiplist_hash_index() : count(0) {}
+		__skiplist_hash_index(__skiplist_hash_index &&rhs) noexcept
+			: slots(std::move(rhs.slots)), count(rhs.count), hasher(rhs.hasher) { rhs.count = 0; }
+
+		// 查找key与k等价的节点，eq(a, b)判断两个key是否等价，不存在时返回空
+		template <typename Equal>
+		Node* find(const Key &k, Equal eq) const {
+			if (!count) return nullptr;
+			size_t h = mix(hasher(k));
+			for (size_t i = h & mask(); slots[i].node; i = (i + 1) & mask())
+				if (slots[i].hash == h && eq(key(slots[i].node), k)) return slots[i].node;
+			return nullptr;
+		}
+
+		// 加入节点，要求索引中不存在与其key等价的节点
+		void insert(Node *node) {
+			if ((count + 1) * 2 > slots.size()) rehash(slots.empty() ? 16 : slots.size() * 2);
+			size_t h = mix(hasher(key(node)));
+			size_t i = h & mask();
+			while (slots[i].node) i = (i + 1) & mask();
+			slots[i] = slot{h, node};
+			++count;
+		}
+
+		// 删除节点，按节点指针而不是key来定位槽
+		void erase(Node *node) {
+			size_t h = mix(hasher(key(node)));
+			size_t i = h & mask();
+			while (slots[i].node != node) i = (i + 1) & mask();
+			// 后向移位：若后续元素的初始位置不在(i, j]范围内，则将其移到空出的位置i
+			for (size_t j = (i + 1) & mask(); slots[j].node; j = (j + 1) & mask()) {
+				size_t home = slots[j].hash & mask();
+				if (((j - home) & mask()) >= ((j - i) & mask())) {
+					slots[i] = slots[j];
+					i = j;
+				}
+			}
+			slots[i] = slot{0, nullptr};
+			--count;
+		}
+
+		// 将节点old替换为key与其等价的节点node，用于节点被重新分配时
+		void replace(Node *old, Node *node) {
+			size_t i = mix(hasher(key(node))) & mask();
+			while (slots[i].node != old) i = (i + 1) & mask();
+			slots[i].node = node;
+		}
+
+		// 清空索引，保留已分配的槽
+		void clear() {
+			for (slot &s : slots) s = slot{0, nullptr};
+			count = 0;
+		}
+
+		// 预留足以容纳n个节点的槽
+		void reserve(size_t n) {
+			size_t capacity = slots.empty() ? 16 : slots.size();
+			while (capacity < n * 2) capacity *= 2;
+			if (capacity != slots.size()) rehash(capacity);
+		}
+
+		void swap(__skiplist_hash_index &rhs) {
+			slots.swap(rhs.slots);
+			std::swap(count, rhs.count);
+			std::swap(hasher, rhs.hasher);
+		}
+};
+
+#endif
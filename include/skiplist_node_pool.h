@@ -0,0 +1,251 @@
+#ifndef SKIPLIST_NODE_POOL_H
+#define SKIPLIST_NODE_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+// 不使用节点池时直接从堆上分配节点
+// compact按key的顺序重新分配节点时，从按segment_bytes对齐的连续内存段中依次分配，使相邻的节点位于相邻的地址
+// 段头记录段中仍存活的节点数，段中的节点全部释放后将整段归还给系统；正在分配的段额外持有一个计数，换段时释放
+struct __skiplist_heap_allocator {
+	public:
+		static const size_t segment_bytes = size_t(1) << 20;
+
+	private:
+		struct alignas(16) segment_header {
+			std::atomic<size_t> live;
+		};
+
+		static inline std::mutex mtx;
+		static inline char *next;
+		static inline char *end;
+
+		static segment_header* segment_of(void *p) {
+			return reinterpret_cast<segment_header*>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(segment_bytes - 1));
+		}
+		static void release(segment_header *segment) {
+			if (segment->live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				segment->~segment_header();
+				std::free(segment);
+			}
+		}
+
+	public:
+		static void* allocate(size_t bytes) { return ::operator new(bytes); }
+
+		// 在当前的段中连续地分配节点，节点超过段大小的1/16时返回空，由调用者改用allocate
+		static void* allocate_sequential(size_t bytes) {
+			bytes = (bytes + alignof(segment_header) - 1) / alignof(segment_header) * alignof(segment_header);
+			if (bytes > segment_bytes / 16) return nullptr;
+			std::lock_guard<std::mutex> lock(mtx);
+			if (!next || size_t(end - next) < bytes) {
+				char *segment = static_cast<char*>(std::aligned_alloc(segment_bytes, segment_bytes));
+				if (!segment) throw std::bad_alloc();
+				new (segment) segment_header{{1}};
+				if (next) release(segment_of(next - 1));
+				next = segment + sizeof(segment_header);
+				end = segment + segment_bytes;
+			}
+			segment_of(next)->live.fetch_add(1, std::memory_order_relaxed);
+			char *p = next;
+			next += bytes;
+			return p;
+		}
+
+		// 释放节点，sequential表示节点是否由allocate_sequential分配
+		static void deallocate(void *p, bool sequential = false) {
+			if (sequential) release(segment_of(p));
+			else ::operator delete(p);
+		}
+
+		// freeze使用的节点数组，count个大小为stride的节点连续存放，不会被单独释放
+		static void* allocate_array(size_t stride, size_t &count) { return ::operator new(stride * count); }
+		static void deallocate_array(void *p, size_t, size_t) { ::operator delete(p); }
+};
+
+// 紧凑模式下的节点池，使节点可以用32位的引用代替64位的指针
+// 节点分配在按chunk_bytes对齐的块（chunk）中，每个块只存放同一大小的节点，块的第一个单位为块头，记录块的编号和节点大小
+// compact按key的顺序重新分配节点时使用连续块：不同大小的节点按分配顺序混合存放，块头记录块中存活的节点数，
+// 节点全部释放后整块放入备用块链表；正在分配的连续块额外持有一个计数，换块时释放
+// 引用的高位为块的编号，低位为节点在块内以granule为单位的偏移，块头的偏移为0，因此引用0不对应任何节点，可用于表示空
+// 每种节点类型共享一个节点池，最多容纳max_chunks个块（共64GB），使用同一节点类型的所有跳表共同受此限制
+// 释放的节点按大小放入空闲链表以供复用，这些块本身不归还给系统
+// 节点的forward数组被重新分配到节点之外时同样由节点池分配，使节点可以用32位的引用找到它
+// freeze使用的节点数组独占一个块，释放数组时整块放入备用块链表，之后分配新块时（任何大小的节点或节点数组）优先复用
+// 分配和释放需要加锁，解码引用只读取块表，不需要加锁
+template <typename Node>
+class __skiplist_node_pool {
+	public:
+		typedef uint32_t ref_type;
+
+		static const size_t granule = 16;
+		static const unsigned offset_bits = 20;
+		static const size_t chunk_bytes = granule << offset_bits;
+		static const size_t max_chunks = size_t(1) << (32 - offset_bits);
+
+	private:
+		struct chunk_header {
+			uint32_t number;
+			// 块中节点的单位数，连续块中节点的大小不一，为0
+			uint32_t units;
+			// 连续块中存活的节点数
+			uint32_t live;
+		};
+		// 同一大小的节点所在的当前块的剩余空间，以及释放的节点组成的链表，链表节点的前4字节保存下一个节点的引用
+		struct size_class {
+			char *next;
+			char *end;
+			ref_type free_list;
+		};
+		// 节点的结构、forward数组和后继key数组最多占用的单位数
+		static const size_t max_units = (sizeof(Node) + 64 * 2 * sizeof(uint64_t)) / granule + 1;
+
+		// 均为零初始化的静态数组，不需要动态初始化，也不会在程序退出时析构，因此静态对象中的跳表也可以安全地释放节点
+		static inline char *chunks[max_chunks];
+		static inline size_t chunk_count;
+		static inline size_class classes[max_units + 1];
+		// 备用块链表，链表节点保存在块的第二个单位中
+		static inline char *spare_chunks;
+		// 正在分配的连续块的剩余空间
+		static inline char *sequential_next;
+		static inline char *sequential_end;
+		static inline std::mutex mtx;
+
+		static_assert(alignof(Node) <= granule, "node alignment exceeds the pool granule");
+
+		static char* chunk_of(const void *p) {
+			return reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(chunk_bytes - 1));
+		}
+		static chunk_header* header_of(char *chunk) { return reinterpret_cast<chunk_header*>(chunk); }
+		// 为大小为units的节点取得一个块，优先复用备用块，复用时保留块的编号，调用者需持有锁
+		static char* take_chunk(size_t units) {
+			char *chunk = spare_chunks;
+			if (chunk) {
+				spare_chunks = *reinterpret_cast<char**>(chunk + granule);
+			} else {
+				if (chunk_count == max_chunks) throw std::bad_alloc();
+				chunk = static_cast<char*>(std::aligned_alloc(chunk_bytes, chunk_bytes));
+				if (!chunk) throw std::bad_alloc();
+				header_of(chunk)->number = uint32_t(chunk_count);
+				chunks[chunk_count++] = chunk;
+			}
+			header_of(chunk)->units = uint32_t(units);
+			header_of(chunk)->live = 0;
+			return chunk;
+		}
+		// 将整块放入备用块链表，调用者需持有锁
+		static void put_spare(char *chunk) {
+			*reinterpret_cast<char**>(chunk + granule) = spare_chunks;
+			spare_chunks = chunk;
+		}
+		// 释放连续块的一个计数，计数为0时将整块放入备用块链表，调用者需持有锁
+		static void release_sequential(char *chunk) {
+			if (!--header_of(chunk)->live) put_spare(chunk);
+		}
+		// 为大小为units的节点分配新的当前块，调用者需持有锁
+		static void new_chunk(size_class &c, size_t units) {
+			char *chunk = take_chunk(units);
+			c.next = chunk + granule;
+			c.end = chunk + chunk_bytes;
+		}
+
+	public:
+		// 分配bytes字节的节点内存，块的数量达到上限时抛出std::bad_alloc
+		static void* allocate(size_t bytes) {
+			size_t units = (bytes + granule - 1) / granule;
+			if (units > max_units) throw std::bad_alloc();
+			std::lock_guard<std::mutex> lock(mtx);
+			size_class &c = classes[units];
+			if (c.free_list) {
+				char *p = reinterpret_cast<char*>(decode(c.free_list));
+				c.free_list = *reinterpret_cast<ref_type*>(p);
+				return p;
+			}
+			if (c.end - c.next < ptrdiff_t(units * granule)) new_chunk(c, units);
+			char *p = c.next;
+			c.next += units * granule;
+			return p;
+		}
+
+		// compact按key的顺序重新分配节点时，不区分节点大小，在当前的连续块中依次分配，使相邻的节点位于相邻的地址
+		static void* allocate_sequential(size_t bytes) {
+			size_t units = (bytes + granule - 1) / granule;
+			if (units > max_units) throw std::bad_alloc();
+			std::lock_guard<std::mutex> lock(mtx);
+			if (sequential_end - sequential_next < ptrdiff_t(units * granule)) {
+				char *chunk = take_chunk(0);
+				header_of(chunk)->live = 1;
+				if (sequential_next) release_sequential(chunk_of(sequential_next - 1));
+				sequential_next = chunk + granule;
+				sequential_end = chunk + chunk_bytes;
+			}
+			++header_of(chunk_of(sequential_next))->live;
+			char *p = sequential_next;
+			sequential_next += units * granule;
+			return p;
+		}
+
+		// 释放节点内存，sequential表示节点是否由allocate_sequential分配
+		// 其他节点的大小由所在块的块头得到，放入对应大小的空闲链表
+		static void deallocate(void *p, bool sequential = false) {
+			char *chunk = chunk_of(p);
+			std::lock_guard<std::mutex> lock(mtx);
+			if (sequential) {
+				release_sequential(chunk);
+				return;
+			}
+			size_t units = header_of(chunk)->units;
+			*static_cast<ref_type*>(p) = classes[units].free_list;
+			classes[units].free_list = encode(p);
+		}
+
+		// freeze使用的节点数组，每个数组独占一个块，块中的节点连续存放，count减小为一个块所能容纳的节点数
+		// 块不作为任何大小的当前块，释放数组时数组中的节点均已析构，整块放入备用块链表
+		static void* allocate_array(size_t stride, size_t &count) {
+			size_t units = (stride + granule - 1) / granule;
+			if (units > max_units) throw std::bad_alloc();
+			size_t capacity = (chunk_bytes - granule) / (units * granule);
+			if (count > capacity) count = capacity;
+			std::lock_guard<std::mutex> lock(mtx);
+			return take_chunk(units) + granule;
+		}
+		static void deallocate_array(void *p, size_t, size_t) {
+			char *chunk = chunk_of(p);
+			std::lock_guard<std::mutex> lock(mtx);
+			put_spare(chunk);
+		}
+
+		// 节点地址与引用的相互转换
+		static ref_type encode(const void *p) {
+			char *chunk = chunk_of(p);
+			return (ref_type(reinterpret_cast<chunk_header*>(chunk)->number) << offset_bits)
+				| ref_type((static_cast<const char*>(p) - chunk) / granule);
+		}
+		static Node* decode(ref_type ref) {
+			return reinterpret_cast<Node*>(chunks[ref >> offset_bits] + (ref & ((ref_type(1) << offset_bits) - 1)) * granule);
+		}
+};
+
+// 紧凑模式下forward数组的元素，以32位的引用保存后继节点，0表示空
+// 可以隐式地与节点指针相互转换，因此跳表中读写forward数组的代码无需区分两种模式
+// 默认构造函数是平凡的，forward数组仍可通过bzero清零
+template <typename Node>
+class __skiplist_compact_link {
+	private:
+		// 节点池只在成员函数中使用，此时节点类型已完整
+		typedef __skiplist_node_pool<Node> pool;
+		uint32_t ref;
+
+	public:
+		__skiplist_compact_link() = default;
+		__skiplist_compact_link(Node *p) : ref(p ? pool::encode(p) : 0) {}
+
+		operator Node*() const { return ref ? pool::decode(ref) : nullptr; }
+		Node* operator->() const { return pool::decode(ref); }
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef SKIPLIST_OBSERVER_H
+#define SKIPLIST_OBSERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// 被观察的跳表操作
+enum skiplist_op {
+	skiplist_op_insert,
+	skiplist_op_find,
+	skiplist_op_erase,
+	skiplist_op_count
+};
+
+// 不记录任何信息的追踪对象，查找循环中对它的调用在编译后全部消失
+struct __skiplist_no_trace {
+	bool active() const { return false; }
+	void hops(size_t, size_t) {}
+};
+
+// 默认的观察者，不做任何事，跳表的操作不产生任何额外开销
+struct skiplist_null_observer {
+	struct trace : __skiplist_no_trace {
+		trace(skiplist_null_observer&, skiplist_op) {}
+	};
+};
+
+// 无锁的HDR风格直方图，记录非负整数值（纳秒）的分布
+// 小于32的值各占一个桶，其余的值按2的幂分段，每段再均分为32个桶，因此任意值的相对误差不超过1/32
+// 各桶的计数为原子变量，多个线程可以同时记录，读取分位数时不需要停止记录
+class __skiplist_histogram {
+	private:
+		static const unsigned sub_bits = 5;
+		static const size_t sub_count = size_t(1) << sub_bits;
+		static const size_t bucket_count = sub_count + (64 - sub_bits) * sub_count;
+
+		std::atomic<uint64_t> buckets[bucket_count];
+
+		static size_t index(uint64_t v) {
+			if (v < sub_count) return v;
+			unsigned shift = 63 - __builtin_clzll(v) - sub_bits;
+			return sub_count + shift * sub_count + ((v >> shift) - sub_count);
+		}
+		// 桶中的最大值
+		static uint64_t highest(size_t i) {
+			if (i < sub_count) return i;
+			unsigned shift = (i - sub_count) / sub_count;
+			uint64_t mantissa = sub_count + (i - sub_count) % sub_count;
+			return ((mantissa + 1) << shift) - 1;
+		}
+
+	public:
+		__skiplist_histogram() { reset(); }
+
+		void record(uint64_t v) { buckets[index(v)].fetch_add(1, std::memory_order_relaxed); }
+
+		uint64_t count() const {
+			uint64_t n = 0;
+			for (size_t i = 0; i < bucket_count; ++i) n += buckets[i].load(std::memory_order_relaxed);
+			return n;
+		}
+
+		// 分位数q（0~1）处的值，取所在桶的最大值，没有记录时返回0
+		uint64_t percentile(double q) const {
+			uint64_t n = count();
+			if (!n) return 0;
+			uint64_t rank = uint64_t(q * n);
+			if (rank >= n) rank = n - 1;
+			uint64_t seen = 0;
+			for (size_t i = 0; i < bucket_count; ++i) {
+				seen += buckets[i].load(std::memory_order_relaxed);
+				if (seen > rank) return highest(i);
+			}
+			return highest(bucket_count - 1);
+		}
+
+		void reset() {
+			for (size_t i = 0; i < bucket_count; ++i) buckets[i].store(0, std::memory_order_relaxed);
+		}
+};
+
+// 记录操作延迟和查找路径的观察者，可在生产环境中使用
+// 平均每2^SampleShift次操作采样一次，只有被采样的操作才读取时钟并更新原子计数，未被采样的操作只需生成一个线程局部的随机数，并执行与未启用观察者时相同的查找
+// 被采样的操作将延迟（纳秒）记录到该操作的直方图中，将查找时在每层前进的次数累加到该层的计数中
+// 各计数均为原子变量，多个线程同时查找时也可以使用；统计信息属于跳表对象本身，不随复制、移动和交换转移
+template <unsigned SampleShift = 6>
+class skiplist_latency_observer {
+	public:
+		static const size_t max_levels = 64;
+
+		class trace {
+			private:
+				skiplist_latency_observer *observer;
+				skiplist_op op;
+				std::chrono::steady_clock::time_point start;
+
+			public:
+				trace(skiplist_latency_observer &o, skiplist_op op) : observer(sampled() ? &o : nullptr), op(op) {
+					if (observer) start = std::chrono::steady_clock::now();
+				}
+				~trace() {
+					if (!observer) return;
+					auto elapsed = std::chrono::steady_clock::now() - start;
+					observer->histograms[op].record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+				}
+				trace(const trace&) = delete;
+				trace& operator=(const trace&) = delete;
+
+				// 本次操作是否被采样
+				bool active() const { return observer != nullptr; }
+				// 查找在第level层前进了n步，只在被采样的操作中调用
+				void hops(size_t level, size_t n) {
+					if (n) observer->level_hops[level].fetch_add(n, std::memory_order_relaxed);
+				}
+		};
+
+		skiplist_latency_observer() { reset(); }
+		skiplist_latency_observer(const skiplist_latency_observer&) = delete;
+		skiplist_latency_observer& operator=(const skiplist_latency_observer&) = delete;
+
+		// 操作op被采样的次数
+		uint64_t count(skiplist_op op) const { return histograms[op].count(); }
+		// 操作op的延迟在分位数q处的值（纳秒），例如percentile(skiplist_op_find, 0.99)
+		uint64_t percentile(skiplist_op op, double q) const { return histograms[op].percentile(q); }
+		// 被采样的操作在第level层前进的总步数，除以各操作的采样次数之和即为每次操作的平均值
+		uint64_t hops(size_t level) const { return level_hops[level].load(std::memory_order_relaxed); }
+
+		void reset() {
+			for (size_t i = 0; i < skiplist_op_count; ++i) histograms[i].reset();
+			for (size_t i = 0; i < max_levels; ++i) level_hops[i].store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		__skiplist_histogram histograms[skiplist_op_count];
+		std::atomic<uint64_t> level_hops[max_levels];
+
+		// 使用线程局部的xorshift随机数决定是否采样，避免与周期性的访问模式同步
+		static bool sampled() {
+			if (SampleShift == 0) return true;
+			static thread_local uint32_t seed = 2463534242u;
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			return (seed & ((uint32_t(1) << SampleShift) - 1)) == 0;
+		}
+};
+
+#endif
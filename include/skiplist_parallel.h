@@ -0,0 +1,93 @@
+#ifndef SKIPLIST_PARALLEL_H
+#define SKIPLIST_PARALLEL_H
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 并行操作的参数，threads为使用的线程数，为0时使用硬件支持的并发线程数
+struct skiplist_parallel {
+	size_t threads;
+	explicit skiplist_parallel(size_t threads = 0) : threads(threads) {}
+
+	// 获取实际使用的线程数
+	size_t concurrency() const {
+		size_t n = threads ? threads : std::thread::hardware_concurrency();
+		return n ? n : 1;
+	}
+};
+
+// 工作窃取线程池，用于执行一组相互独立的任务
+// 每个线程拥有一个任务队列，优先从自己队列的尾部取任务，自己的队列为空时从其他线程队列的头部窃取任务
+// 任务的执行时间可能相差很大（例如跳表分块的大小不均匀），窃取使得空闲线程能分担其他线程的任务
+class __work_stealing_pool {
+	private:
+		// 每个线程的任务队列，任务以编号表示
+		struct worker_queue {
+			std::mutex mtx;
+			std::deque<size_t> tasks;
+		};
+
+		size_t thread_count;
+		std::vector<worker_queue> queues;
+
+		// 从自己的队列尾部取任务，成功则返回true
+		bool pop(size_t self, size_t &task) {
+			std::lock_guard<std::mutex> lock(queues[self].mtx);
+			if (queues[self].tasks.empty()) return false;
+			task = queues[self].tasks.back();
+			queues[self].tasks.pop_back();
+			return true;
+		}
+		// 从其他线程的队列头部窃取任务，成功则返回true
+		bool steal(size_t self, size_t &task) {
+			for (size_t i = 1; i < thread_count; ++i) {
+				worker_queue &victim = queues[(self + i) % thread_count];
+				std::lock_guard<std::mutex> lock(victim.mtx);
+				if (victim.tasks.empty()) continue;
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+				return true;
+			}
+			return false;
+		}
+
+	public:
+		explicit __work_stealing_pool(size_t thread_count) : thread_count(thread_count ? thread_count : 1), queues(this->thread_count) {}
+
+		// 执行编号为[0, task_count)的任务，fn(i)执行第i个任务，所有任务执行完毕后返回
+		// 任务不会产生新的任务，因此所有队列都为空时线程即可退出
+		// 若有任务抛出异常，则在所有线程结束后重新抛出第一个异常
+		template <typename Function>
+		void run(size_t task_count, Function fn) {
+			// 按轮转的方式将任务分配到各线程的队列中
+			for (size_t i = 0; i < task_count; ++i) queues[i % thread_count].tasks.push_back(i);
+
+			std::mutex error_mtx;
+			std::exception_ptr error;
+			auto work = [&](size_t self) {
+				size_t task;
+				while (pop(self, task) || steal(self, task)) {
+					try {
+						fn(task);
+					} catch (...) {
+						std::lock_guard<std::mutex> lock(error_mtx);
+						if (!error) error = std::current_exception();
+					}
+				}
+			};
+
+			// 当前线程作为第0个工作线程参与执行
+			std::vector<std::thread> workers;
+			for (size_t i = 1; i < thread_count; ++i) workers.push_back(std::thread(work, i));
+			work(0);
+			for (auto &worker : workers) worker.join();
+
+			if (error) std::rethrow_exception(error);
+		}
+};
+
+#endif
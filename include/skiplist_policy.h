@@ -0,0 +1,92 @@
+#ifndef SKIPLIST_POLICY_H
+#define SKIPLIST_POLICY_H
+
+#include <functional>
+#include "skiplist_observer.h"
+
+// 跳表的平衡方式
+enum skiplist_balance {
+	// 随机平衡：节点层级在插入时随机生成，查找的期望时间复杂度为O(log n)
+	skiplist_random_balance,
+	// 确定性平衡（1-2-3跳表）：每层相邻两个高层节点之间恰有1~3个该层的节点
+	// 插入和删除时通过提升和降低节点的层级维持该性质，查找的最坏时间复杂度为O(log n)
+	skiplist_deterministic_balance,
+	// 自适应平衡：在随机层级的基础上，对查找进行采样并统计节点的访问频率
+	// 访问频繁的节点被提升到更高的层级，冷却后再逐层降低，适用于访问分布高度倾斜（如Zipf分布）的场景
+	skiplist_adaptive_balance
+};
+
+// 跳表的默认策略
+// 自定义策略时继承该类并覆盖相应的成员即可，例如：
+// struct my_policy : skiplist_default_policy {
+//     static const skiplist_balance balance = skiplist_deterministic_balance;
+// };
+struct skiplist_default_policy {
+	// 平衡方式
+	static const skiplist_balance balance = skiplist_random_balance;
+	// 自适应平衡模式下，平均每2^sample_shift次查找采样一次
+	static const unsigned int sample_shift = 4;
+	// 是否维护key到节点的哈希索引，使find等按key的查找为O(1)，代价是每个节点额外占用约两个槽的内存
+	static const bool hash_index = false;
+	// 哈希索引使用的哈希函数，要求与Compare的等价关系一致（等价的key哈希值相同）
+	template <typename Key>
+	using hasher = std::hash<Key>;
+	// 是否在forward数组旁缓存每层后继节点的key，只对不超过8字节且可平凡复制的key生效
+	// 查找时只需比较当前节点中缓存的key即可决定是否前进，只有前进时才访问后继节点
+	// 每次前进或下降前都不必读取后继节点，查找访问的缓存行约减少一半，skip_set和skip_map均适用
+	static const bool cached_links = false;
+	// 是否以32位的引用代替forward数组中的64位指针，节点由按块管理的节点池分配，只对不使用key缓存（定长key）的跳表生效
+	// 每层的链接占用的内存减半，节点也不再保存forward数组的地址，适用于内存受限的大规模跳表
+	// 节点池由同一节点类型的所有跳表共享，容量上限为64GB（4096个16MB的块），按每个节点32字节计约可容纳20亿个节点
+	// 超出上限时插入抛出std::bad_alloc；释放的节点只在同一节点池内复用，只有compact整理到连续块中的节点全部释放后，其所在的块才可被任何大小的节点复用
+	static const bool compact_links = false;
+	// 是否允许一个写者与多个读者同时访问跳表（单写多读），只适用于随机平衡且不维护哈希索引的跳表
+	// 写者自底向上以release语义发布新节点的各层链接，读者以acquire语义读取，读者无需加锁或重试
+	static const bool concurrent_readers = false;
+	// 观察者，用于记录各操作的延迟和查找路径，例如skiplist_latency_observer<>
+	typedef skiplist_null_observer observer;
+};
+
+// 确定性平衡的策略，用于对最坏情况下的查找延迟有要求的场景
+struct skiplist_deterministic_policy : skiplist_default_policy {
+	static const skiplist_balance balance = skiplist_deterministic_balance;
+};
+
+// 自适应平衡的策略，用于热点key集中的查找负载
+// 查找会调整节点的层级，因此即使只有查找操作，多线程访问时也需要外部同步
+struct skiplist_adaptive_policy : skiplist_default_policy {
+	static const skiplist_balance balance = skiplist_adaptive_balance;
+};
+
+// 维护哈希索引的策略，用于点查询远多于范围查询的场景
+// 可与其他平衡方式组合，例如：
+// struct my_policy : skiplist_deterministic_policy {
+//     static const bool hash_index = true;
+// };
+struct skiplist_hash_index_policy : skiplist_default_policy {
+	static const bool hash_index = true;
+};
+
+// 缓存后继key的策略，用于整数等小key的大规模skip_map，每层额外占用一个key的空间
+struct skiplist_cached_links_policy : skiplist_default_policy {
+	static const bool cached_links = true;
+};
+
+// 紧凑链接的策略，用于整数等定长key的大规模跳表，可与缓存后继key组合使用（4字节的key）
+struct skiplist_compact_policy : skiplist_default_policy {
+	static const bool compact_links = true;
+};
+
+// 单写多读的策略，与LevelDB的memtable相同：一个线程插入和删除，多个线程同时调用find、lower_bound并遍历迭代器
+// 删除的节点推迟到写者调用reclaim时销毁，此时不能有读者访问跳表；其他修改操作（clear、merge、split、swap、extract等）也需在没有读者时进行
+struct skiplist_single_writer_policy : skiplist_default_policy {
+	static const bool concurrent_readers = true;
+};
+
+// 记录延迟分布和每层查找步数的策略，默认每64次操作采样一次
+// 通过get_observer().percentile(skiplist_op_find, 0.99)等读取统计信息
+struct skiplist_traced_policy : skiplist_default_policy {
+	typedef skiplist_latency_observer<> observer;
+};
+
+#endif
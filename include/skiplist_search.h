@@ -0,0 +1,181 @@
+#ifndef SKIPLIST_SEARCH_H
+#define SKIPLIST_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+// 跳表查找策略，决定查找循环中每一步的比较方式
+// 默认情况下沿用普通的分支式比较：后继存在且后继的key小于目标key时前进，否则下降一层
+template <typename Key, typename Compare>
+struct __skiplist_search_traits {
+	// 是否使用无分支的查找步进
+	static const bool branchless = false;
+};
+
+// 对于使用std::less比较的算术类型key，比较操作本身没有副作用且代价极低
+// 因此查找循环可以改写为无分支形式：用条件传送（cmov）选择前进或下降，避免随机key导致的分支预测失败
+template <typename Key>
+struct __skiplist_search_traits<Key, std::less<Key>> {
+	static const bool branchless = std::is_arithmetic<Key>::value;
+};
+
+// 节点内联的key缓存，与节点在同一块内存中分配，位于节点结构之后
+// 查找时先将目标key预处理为probe_type，再用compare比较缓存与probe，从而避免解引用节点中的key
+// 默认不缓存任何内容，直接使用Compare比较节点中的key
+template <typename Key, typename Compare>
+struct __skiplist_key_cache {
+	static const bool enabled = false;
+	typedef const Key* probe_type;
+
+	// 缓存所需的字节数
+	static size_t size(const Key&) { return 0; }
+	// 在cache指向的内存中构造缓存
+	static void construct(void*, const Key&) {}
+	// 预处理目标key
+	static probe_type probe(const Key &k) { return &k; }
+	// 比较缓存与目标key，小于、等于、大于分别返回负数、0、正数
+	static int compare(const void*, const probe_type&) { return 0; }
+};
+
+// 将字符串的前8个字节规范化为大端序整数（不足8字节时补0）
+// 整数的大小关系与按无符号字节进行字典序比较的结果一致
+inline uint64_t __string_key_prefix(const char *data, size_t length) {
+	unsigned char bytes[8] = {0};
+	memcpy(bytes, data, length < 8 ? length : 8);
+	uint64_t prefix = 0;
+	for (int i = 0; i < 8; ++i) prefix = (prefix << 8) | bytes[i];
+	return prefix;
+}
+
+// 使用std::less比较的std::string类型的key，将其前缀和字节内联到节点中
+// 节点中的std::string在长度超过SSO容量时，其字节存放在另一块堆内存中，每次比较都要额外解引用一次
+// 内联后大多数比较只需比较一次8字节的前缀，只有前缀相同时才需要比较节点内联的剩余字节
+template <>
+struct __skiplist_key_cache<std::string, std::less<std::string>> {
+	static const bool enabled = true;
+
+	// 缓存的布局：前缀、长度，之后紧跟第8个字节以后的剩余字节
+	struct cache_type {
+		uint64_t prefix;
+		size_t length;
+		const char* tail() const { return reinterpret_cast<const char*>(this + 1); }
+	};
+
+	struct probe_type {
+		uint64_t prefix;
+		size_t length;
+		const char *data;
+	};
+
+	static size_t size(const std::string &k) {
+		return sizeof(cache_type) + (k.size() > 8 ? k.size() - 8 : 0);
+	}
+	static void construct(void *cache, const std::string &k) {
+		cache_type *c = static_cast<cache_type*>(cache);
+		c->prefix = __string_key_prefix(k.data(), k.size());
+		c->length = k.size();
+		if (k.size() > 8) memcpy(reinterpret_cast<char*>(c + 1), k.data() + 8, k.size() - 8);
+	}
+	static probe_type probe(const std::string &k) {
+		probe_type p = { __string_key_prefix(k.data(), k.size()), k.size(), k.data() };
+		return p;
+	}
+	static int compare(const void *cache, const probe_type &p) {
+		const cache_type *c = static_cast<const cache_type*>(cache);
+		// 前缀不同时即可确定大小关系
+		if (c->prefix != p.prefix) return c->prefix < p.prefix ? -1 : 1;
+		// 前缀相同时，比较第8个字节以后的公共部分，再比较长度
+		size_t n = c->length < p.length ? c->length : p.length;
+		if (n > 8) {
+			int r = memcmp(c->tail(), p.data + 8, n - 8);
+			if (r) return r;
+		}
+		return c->length < p.length ? -1 : (c->length > p.length ? 1 : 0);
+	}
+};
+
+// 统计连续存放的n个key中小于k的数量，即k在有序数组中的插入位置，用于冻结索引中每块的计数
+// 对于32位和64位整数key，一次比较4~16个元素，其余情况使用无分支的标量实现
+// 只有冻结索引的key是连续存放的；未冻结的跳表每一步只比较一个后继的key（缓存后继key时也是如此），仍使用上面的标量查找步进
+template <typename Key>
+inline size_t __simd_count_less(const Key *keys, size_t n, const Key &k) {
+	size_t count = 0;
+	for (size_t i = 0; i < n; ++i) count += keys[i] < k;
+	return count;
+}
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+// 无符号整数需要先翻转符号位，才能使用有符号的比较指令
+template <typename Key, bool IsSigned = std::is_signed<Key>::value>
+struct __simd_sign_bias { static const Key value = Key(0); };
+
+template <typename Key>
+struct __simd_sign_bias<Key, false> { static const Key value = Key(Key(1) << (sizeof(Key)*8-1)); };
+
+template <typename Key>
+inline typename std::enable_if<std::is_integral<Key>::value && sizeof(Key) == 8, size_t>::type
+__simd_count_less_impl(const Key *keys, size_t n, const Key &k) {
+	const long long bias = (long long)__simd_sign_bias<Key>::value;
+	size_t count = 0, i = 0;
+#if defined(__AVX2__)
+	const __m256i vbias = _mm256_set1_epi64x(bias);
+	const __m256i probe = _mm256_xor_si256(_mm256_set1_epi64x((long long)k), vbias);
+	for (; i + 4 <= n; i += 4) {
+		__m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(keys+i)), vbias);
+		// probe > keys[i] 即 keys[i] < k
+		int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(probe, v)));
+		count += __builtin_popcount(mask);
+	}
+#endif
+	const __m128i sbias = _mm_set1_epi64x(bias);
+	const __m128i sprobe = _mm_xor_si128(_mm_set1_epi64x((long long)k), sbias);
+	for (; i + 2 <= n; i += 2) {
+		__m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys+i)), sbias);
+		int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(sprobe, v)));
+		count += __builtin_popcount(mask);
+	}
+	for (; i < n; ++i) count += keys[i] < k;
+	return count;
+}
+
+template <typename Key>
+inline typename std::enable_if<std::is_integral<Key>::value && sizeof(Key) == 4, size_t>::type
+__simd_count_less_impl(const Key *keys, size_t n, const Key &k) {
+	const int bias = (int)__simd_sign_bias<Key>::value;
+	size_t count = 0, i = 0;
+#if defined(__AVX2__)
+	const __m256i vbias = _mm256_set1_epi32(bias);
+	const __m256i probe = _mm256_xor_si256(_mm256_set1_epi32((int)k), vbias);
+	for (; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(keys+i)), vbias);
+		int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(probe, v)));
+		count += __builtin_popcount(mask);
+	}
+#endif
+	const __m128i sbias = _mm_set1_epi32(bias);
+	const __m128i sprobe = _mm_xor_si128(_mm_set1_epi32((int)k), sbias);
+	for (; i + 4 <= n; i += 4) {
+		__m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys+i)), sbias);
+		int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(sprobe, v)));
+		count += __builtin_popcount(mask);
+	}
+	for (; i < n; ++i) count += keys[i] < k;
+	return count;
+}
+
+// 以下重载优先于通用的标量版本被选中
+inline size_t __simd_count_less(const uint64_t *keys, size_t n, const uint64_t &k) { return __simd_count_less_impl(keys, n, k); }
+inline size_t __simd_count_less(const int64_t *keys, size_t n, const int64_t &k) { return __simd_count_less_impl(keys, n, k); }
+inline size_t __simd_count_less(const uint32_t *keys, size_t n, const uint32_t &k) { return __simd_count_less_impl(keys, n, k); }
+inline size_t __simd_count_less(const int32_t *keys, size_t n, const int32_t &k) { return __simd_count_less_impl(keys, n, k); }
+#endif
+
+#endif
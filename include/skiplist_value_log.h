@@ -0,0 +1,156 @@
+#ifndef SKIPLIST_VALUE_LOG_H
+#define SKIPLIST_VALUE_LOG_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 键值分离（WiscKey）的值日志，跳表中只保存key和指向日志记录的指针，实值保存在日志中
+// 日志由若干段组成，每段是固定数量的记录，新记录总是追加到最后一段（头段）的末尾，头段写满后封存并分配新的头段
+// 每条记录同时保存key和实值，垃圾回收时据此在跳表中找到引用该记录的节点
+// 记录被覆盖或删除时立即析构其中的key和实值，但记录所占的空间要等到垃圾回收时才能释放
+// 垃圾回收将存活记录较少的封存段中仍存活的记录移动到头段，再释放整段
+template <typename Key, typename T>
+class __skiplist_value_log {
+	public:
+		typedef std::pair<const Key, T> entry_type;
+		typedef size_t size_type;
+
+		struct segment;
+		// 日志记录，entry只在live为true时有效
+		struct record {
+			segment *owner;
+			bool live;
+			typename std::aligned_storage<sizeof(entry_type), alignof(entry_type)>::type storage;
+
+			entry_type& entry() { return *reinterpret_cast<entry_type*>(&storage); }
+		};
+		struct segment {
+			record *records;
+			// 已追加的记录数和其中仍存活的记录数
+			size_type used;
+			size_type live;
+		};
+
+		// 每段约1MB，实值很大时每段至少一条记录
+		static const size_type segment_bytes = size_type(1) << 20;
+		static const size_type records_per_segment = sizeof(record) < segment_bytes ? segment_bytes / sizeof(record) : 1;
+
+	private:
+		std::vector<segment*> segments;
+		size_type live_count;
+
+		segment* new_segment() {
+			segment *s = new segment{nullptr, 0, 0};
+			try {
+				s->records = new record[records_per_segment];
+				segments.push_back(s);
+			} catch (...) {
+				delete [] s->records;
+				delete s;
+				throw;
+			}
+			return s;
+		}
+		// 析构段中所有存活的记录并释放该段
+		static void free_segment(segment *s) {
+			for (size_type i = 0; i < s->used; ++i)
+				if (s->records[i].live) s->records[i].entry().~entry_type();
+			delete [] s->records;
+			delete s;
+		}
+
+	public:
+		__skiplist_value_log() : live_count(0) {}
+		__skiplist_value_log(__skiplist_value_log &&rhs) noexcept
+			: segments(std::move(rhs.segments)), live_count(rhs.live_count) { rhs.live_count = 0; }
+		__skiplist_value_log& operator=(__skiplist_value_log &&rhs) noexcept {
+			swap(rhs);
+			return *this;
+		}
+		__skiplist_value_log(const __skiplist_value_log&) = delete;
+		__skiplist_value_log& operator=(const __skiplist_value_log&) = delete;
+		~__skiplist_value_log() { clear(); }
+
+		// 在头段末尾追加一条记录，实值通过复制或移动构造
+		template <typename V>
+		record* append(const Key &k, V &&value) {
+			segment *head = segments.empty() || segments.back()->used == records_per_segment ? new_segment() : segments.back();
+			record *r = head->records + head->used;
+			new (&r->storage) entry_type(k, std::forward<V>(value));
+			r->owner = head;
+			r->live = true;
+			++head->used;
+			++head->live;
+			++live_count;
+			return r;
+		}
+
+		// 记录被覆盖或删除，析构其中的key和实值，空间留给垃圾回收
+		void release(record *r) {
+			r->entry().~entry_type();
+			r->live = false;
+			--r->owner->live;
+			--live_count;
+		}
+
+		// 垃圾回收：存活记录的比例不超过max_live的封存段中，将存活的记录移动到头段后释放整段
+		// 每移动一条记录调用一次relocate(旧记录, 新记录)，由调用者将引用旧记录的节点改为指向新记录，之后旧记录被析构
+		// 返回释放的段数；max_live为0时只释放没有存活记录的段
+		template <typename Relocate>
+		size_type collect(double max_live, Relocate relocate) {
+			// 只处理回收开始前已封存的段，移动过程中新分配的段不参与本次回收
+			size_type sealed = segments.size();
+			if (sealed && segments.back()->used < records_per_segment) --sealed;
+			size_type freed = 0;
+			try {
+				for (size_type i = 0; i < sealed; ++i) {
+					segment *s = segments[i];
+					if (s->live > max_live * records_per_segment) continue;
+					for (size_type j = 0; j < s->used && s->live; ++j) {
+						record *r = s->records + j;
+						if (!r->live) continue;
+						record *moved = append(r->entry().first, std::move_if_noexcept(r->entry().second));
+						relocate(r, moved);
+						release(r);
+					}
+					delete [] s->records;
+					delete s;
+					segments[i] = nullptr;
+					++freed;
+				}
+			} catch (...) {
+				// 追加失败时已移动的记录仍然有效，只需移除已释放的段
+				segments.erase(std::remove(segments.begin(), segments.end(), nullptr), segments.end());
+				throw;
+			}
+			segments.erase(std::remove(segments.begin(), segments.end(), nullptr), segments.end());
+			return freed;
+		}
+
+		// 存活的记录数
+		size_type size() const { return live_count; }
+		// 日志占用的字节数，以及其中被覆盖或删除的记录所占的字节数
+		size_type bytes() const { return segments.size() * records_per_segment * sizeof(record); }
+		size_type garbage_bytes() const {
+			size_type n = 0;
+			for (const segment *s : segments) n += s->used - s->live;
+			return n * sizeof(record);
+		}
+
+		void clear() {
+			for (segment *s : segments) free_segment(s);
+			segments.clear();
+			live_count = 0;
+		}
+
+		void swap(__skiplist_value_log &rhs) {
+			segments.swap(rhs.segments);
+			std::swap(live_count, rhs.live_count);
+		}
+};
+
+#endif
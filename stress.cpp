@@ -8,7 +8,14 @@
 #include "include/skip_set.h"
 
 std::mutex mtx;
+#ifdef SKIPLIST_TRACE
+// 使用记录延迟的策略，测试结束后输出insert和find的延迟分位数
+skip_set<size_t, std::less<size_t>, 0, skiplist_traced_policy> iset;
+#else
 skip_set<size_t> iset;
+#endif
+// 单写多读模式的跳表，一个线程插入时其他线程无锁地查找
+skip_set<size_t, std::less<size_t>, 0, skiplist_single_writer_policy> cset;
 
 void insert(size_t item_nums, size_t thread_nums) {
 	size_t count = item_nums / thread_nums;
@@ -106,6 +113,27 @@ void stl_find(size_t item_nums, size_t thread_nums) {
 #endif
 }
 
+// 单写多读测试中的写者，插入时不加锁
+void writer(size_t item_nums) {
+	std::default_random_engine e(42);
+	std::uniform_int_distribution<size_t> u(0, item_nums);
+	for (size_t i = 0; i < item_nums; ++i) cset.insert(u(e));
+}
+
+// 单写多读测试中的读者，与写者同时查找，不加锁
+void reader(size_t item_nums, size_t thread_nums, size_t seed) {
+	size_t count = item_nums / thread_nums;
+	std::default_random_engine e(seed);
+	std::uniform_int_distribution<size_t> u(0, item_nums);
+	size_t found = 0;
+	for (size_t i = 0; i < count; ++i) found += cset.find(u(e)) != cset.end();
+
+#ifndef NDEBUG
+	std::lock_guard<std::mutex> lock(mtx);
+	std::cout << "thread: " << std::this_thread::get_id()
+		<< " found " << found << " keys" << std::endl;
+#endif
+}
 
 int main(int argc, char* argv[]) {
 	if (argc != 3) {
@@ -154,6 +182,28 @@ int main(int argc, char* argv[]) {
 		std::cout << "find elapsed: " << elapsed.count() << std::endl;
 	}
 
+	// 批量查找测试，对同一批无序的key分别逐个调用find和调用一次find_many，查找结果均保存下来
+	// 跳表远大于末级缓存时，find_many交替进行多个查找，使各查找的缓存缺失重叠
+	{
+		std::default_random_engine e(3407);
+		std::uniform_int_distribution<size_t> u(0, item_nums);
+		std::vector<size_t> keys(item_nums);
+		for (auto &key : keys) key = u(e);
+		std::vector<decltype(iset)::iterator> ret(item_nums);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < item_nums; ++i)
+			ret[i] = iset.find(keys[i]);
+		auto middle = std::chrono::high_resolution_clock::now();
+		iset.find_many(keys.begin(), keys.end(), ret.begin());
+		auto finish = std::chrono::high_resolution_clock::now();
+
+		std::chrono::duration<double> elapsed = middle - start;
+		std::cout << "batch find elapsed: " << elapsed.count() << std::endl;
+		elapsed = finish - middle;
+		std::cout << "find many elapsed: " << elapsed.count() << std::endl;
+	}
+
 	// 查找测试，使用低效的通用find
 	{
 		std::vector<std::thread> threads;
@@ -170,5 +220,34 @@ int main(int argc, char* argv[]) {
 		std::cout << "stl find elapsed: " << elapsed.count() << std::endl;
 	}
 
+	// 单写多读测试，一个写者插入的同时，thread_nums个读者无锁地查找
+	{
+		std::vector<std::thread> threads;
+		threads.reserve(thread_nums + 1);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		threads.push_back(std::thread(writer, item_nums));
+		for (size_t i = 0; i < thread_nums; ++i)
+			threads.push_back(std::thread(reader, item_nums, thread_nums, 3407 + i));
+		for (auto &thread : threads)
+			thread.join();
+		auto finish = std::chrono::high_resolution_clock::now();
+
+		std::chrono::duration<double> elapsed = finish - start;
+		std::cout << "single writer with readers elapsed: " << elapsed.count() << std::endl;
+	}
+
+#ifdef SKIPLIST_TRACE
+	// 输出被采样的操作的延迟分位数（纳秒）
+	const char *names[] = {"insert", "find"};
+	for (int op = skiplist_op_insert; op <= skiplist_op_find; ++op) {
+		auto &observer = iset.get_observer();
+		std::cout << names[op] << " latency(ns): samples=" << observer.count(skiplist_op(op))
+			<< ", p50=" << observer.percentile(skiplist_op(op), 0.5)
+			<< ", p99=" << observer.percentile(skiplist_op(op), 0.99)
+			<< ", p999=" << observer.percentile(skiplist_op(op), 0.999) << std::endl;
+	}
+#endif
+
 	return 0;
 }
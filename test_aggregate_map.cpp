@@ -0,0 +1,105 @@
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include "include/skip_aggregate_map.h"
+
+// 不满足交换律的幺半群：按key的顺序拼接实值，用于检查聚合时各段的合并顺序
+struct concat {
+	typedef std::string result_type;
+	result_type identity() const { return std::string(); }
+	result_type lift(const int &x) const { return std::to_string(x) + ","; }
+	result_type operator()(const result_type &a, const result_type &b) const { return a + b; }
+};
+
+// 在std::map上逐个合并[first, last)中元素的实值，作为聚合值的参照
+template <typename Monoid>
+typename Monoid::result_type brute_force(std::map<int, int>::const_iterator first, std::map<int, int>::const_iterator last) {
+	Monoid monoid;
+	typename Monoid::result_type result = monoid.identity();
+	for (; first != last; ++first) result = monoid(result, monoid.lift(first->second));
+	return result;
+}
+
+// 随机插入、覆盖、修改和删除元素，每轮比较所有元素的聚合值和随机区间的聚合值
+template <typename Monoid>
+void test_aggregate(int range) {
+	skip_aggregate_map<int, int, Monoid> amap;
+	std::map<int, int> ref;
+	srand(range);
+	for (int round = 0; round < 20 * range; ++round) {
+		int k = rand() % range, v = rand() % 1000 - 500;
+		switch (rand() % 4) {
+			case 0: amap.insert(std::make_pair(k, v)); ref.insert(std::make_pair(k, v)); break;
+			case 1: amap.insert_or_assign(k, v); ref[k] = v; break;
+			case 2: amap.modify(k, [v](int &x) { x += v; }); ref[k] += v; break;
+			case 3: assert(amap.erase(k) == ref.erase(k)); break;
+		}
+		if (round % 10) continue;
+		assert(amap.size() == ref.size());
+		assert(amap.aggregate() == brute_force<Monoid>(ref.begin(), ref.end()));
+		int lo = rand() % (range + 2) - 1, hi = rand() % (range + 2) - 1;
+		typename Monoid::result_type expect = lo < hi ? brute_force<Monoid>(ref.lower_bound(lo), ref.lower_bound(hi))
+				: Monoid().identity();
+		assert(amap.aggregate(lo, hi) == expect);
+	}
+	// 拷贝后的聚合值与原容器相同
+	skip_aggregate_map<int, int, Monoid> copy(amap);
+	assert(copy.aggregate() == amap.aggregate());
+	std::cout << "range=" << range << " size=" << amap.size() << std::endl;
+}
+
+// 每次操作都采样的观察者，用于统计查找的步数
+struct traced_every_op_policy : skiplist_default_policy {
+	typedef skiplist_latency_observer<0> observer;
+};
+
+// 层级的生成和层数上限的增长与skiplist相同：初始上限为1时逐个插入，查找的平均步数仍为O(log n)，聚合值在header重新分配后保持正确
+// 编译期指定的MaxLevel不随节点数量增长
+void test_levels() {
+	const int n = 1 << 15;
+	skip_aggregate_map<int, int, skiplist_sum<int>, std::less<int>, 0, traced_every_op_policy> amap(1);
+	std::map<int, int> ref;
+	for (int i = 0; i < n; ++i) {
+		amap.insert(std::make_pair(i * 7919 % n, i % 100));
+		ref[i * 7919 % n] = i % 100;
+	}
+	amap.get_observer().reset();
+	for (int i = 0; i < 1000; ++i) assert(amap.find(i * 31) != amap.end());
+	uint64_t hops = 0;
+	for (size_t level = 0; level < skiplist_latency_observer<0>::max_levels; ++level) hops += amap.get_observer().hops(level);
+	assert(amap.get_observer().count(skiplist_op_find) == 1000 && hops / 1000 < 100);
+	assert(amap.aggregate() == brute_force<skiplist_sum<int>>(ref.begin(), ref.end()));
+	assert(amap.aggregate(100, 20000) == brute_force<skiplist_sum<int>>(ref.lower_bound(100), ref.lower_bound(20000)));
+
+	typedef skip_aggregate_map<int, int, skiplist_max<int>, std::less<int>, 4> small_map;
+	static_assert(small_map::default_max_level == 4, "MaxLevel should be the default max_level");
+	small_map fixed;
+	for (int i = 0; i < 1000; ++i) fixed.insert(std::make_pair(i, i % 37));
+	assert(fixed.aggregate(10, 500) == 36 && fixed.aggregate() == 36);
+	std::cout << "levels ok, hops per find=" << hops / 1000 << std::endl;
+}
+
+// 测试skip_aggregate_map的例子，与在std::map上逐个合并的结果比较
+int main() {
+	skip_aggregate_map<std::string, int> sales;
+	sales.insert(std::make_pair(std::string("2024-01"), 10));
+	sales.insert(std::make_pair(std::string("2024-02"), 20));
+	sales.insert(std::make_pair(std::string("2024-03"), 30));
+	sales.insert(std::make_pair(std::string("2024-04"), 40));
+	// 二月至三月的销量，区间为左闭右开
+	std::cout << sales.aggregate(std::string("2024-02"), std::string("2024-04")) << std::endl;
+	sales.modify(std::string("2024-03"), [](int &x) { x *= 2; });
+	std::cout << sales.aggregate() << std::endl;
+
+	for (int range : {1, 10, 1000}) {
+		test_aggregate<skiplist_sum<int>>(range);
+		test_aggregate<skiplist_min<int>>(range);
+		test_aggregate<skiplist_max<int>>(range);
+		test_aggregate<concat>(range);
+	}
+	test_levels();
+
+	return 0;
+}
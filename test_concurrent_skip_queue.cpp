@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "include/concurrent_skip_queue.h"
+#include "include/skip_set.h"
+
+// skip_set作为优先队列使用，front和pop_front按key从小到大取出元素
+void test_pop_front() {
+	skip_set<int> pq;
+	for (int i = 0; i < 1000; ++i) pq.insert(i * 7919 % 1000);
+	int expect = 0;
+	for (; !pq.empty(); ++expect) {
+		assert(pq.front() == expect);
+		pq.pop_front();
+	}
+	assert(expect == 1000);
+	std::cout << "pop_front ok" << std::endl;
+}
+
+// 只有一个线程时pop_min是精确的，按从小到大的顺序取出所有元素
+void test_exact() {
+	concurrent_skip_queue<int> q(1);
+	for (int i = 0; i < 1000; ++i) q.push(i * 7919 % 1000);
+	int val, expect = 0;
+	while (q.pop_min(val)) assert(val == expect++);
+	assert(expect == 1000 && q.empty());
+	std::cout << "exact pop_min ok" << std::endl;
+}
+
+// 多个线程同时push和pop_min，每个元素恰好被取出一次
+void test_concurrent(int threads) {
+	const int per_thread = 20000;
+	concurrent_skip_queue<int> q(threads);
+	std::vector<std::vector<int>> popped(threads);
+	std::atomic<int> producers(threads);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.push_back(std::thread([&, t]() {
+			for (int i = 0; i < per_thread; ++i) q.push(i * threads + t);
+			--producers;
+		}));
+		workers.push_back(std::thread([&, t]() {
+			int val;
+			for (;;) {
+				if (q.pop_min(val)) popped[t].push_back(val);
+				else if (producers == 0 && q.empty()) break;
+			}
+		}));
+	}
+	for (auto &worker : workers) worker.join();
+
+	std::vector<int> all;
+	for (auto &p : popped) all.insert(all.end(), p.begin(), p.end());
+	std::sort(all.begin(), all.end());
+	assert(int(all.size()) == threads * per_thread);
+	for (int i = 0; i < int(all.size()); ++i) assert(all[i] == i);
+	q.reclaim();
+	std::cout << threads << " threads popped " << all.size() << std::endl;
+}
+
+// 测试skip_set的优先队列用法和concurrent_skip_queue
+int main() {
+	test_pop_front();
+	test_exact();
+	test_concurrent(2);
+	test_concurrent(4);
+
+	return 0;
+}
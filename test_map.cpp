@@ -1,7 +1,29 @@
+#include <cassert>
 #include <iostream>
 #include <string>
+#include <vector>
 #include "include/skip_map.h"
 
+// 被移动后的跳表成为空容器，查找、插入和迭代均可正常进行
+void test_moved_from() {
+	skip_map<std::string, int> simap;
+	simap[std::string("jjhou")] = 1;
+	skip_map<std::string, int> other(std::move(simap));
+	assert(other.size() == 1 && simap.empty());
+	assert(simap.begin() == simap.end() && simap.find(std::string("jjhou")) == simap.end());
+	simap[std::string("jerry")] = 2;
+	assert(simap.size() == 1 && simap.begin()->second == 2);
+	// 移动构造不分配内存，vector扩容时移动而不是复制元素
+	static_assert(std::is_nothrow_move_constructible<skip_map<long, long>>::value, "move constructor should be noexcept");
+	std::vector<skip_map<long, long>> maps;
+	for (long i = 0; i < 100; ++i) {
+		maps.push_back(skip_map<long, long>());
+		maps.back()[i] = i;
+	}
+	for (long i = 0; i < 100; ++i) assert(maps[i].size() == 1 && maps[i].begin()->second == i);
+	std::cout << "moved-from size=" << simap.size() << std::endl;
+}
+
 // 测试skip_map的例子，取自《STL源码剖析》第242页
 int main() {
 	skip_map<std::string, int> simap;
@@ -34,5 +56,7 @@ int main() {
 	int number2 = simap[std::string("jerry")];
 	std::cout << number2 << std::endl;
 
+	test_moved_from();
+
 	return 0;
 }
@@ -1,9 +1,720 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <string>
+#include <vector>
 #include "include/skip_set.h"
 
+// 进程占用的虚拟内存页数，无法读取/proc时返回0
+static size_t virtual_pages() {
+	std::ifstream statm("/proc/self/statm");
+	size_t pages = 0;
+	statm >> pages;
+	return pages;
+}
+
+// 反复冻结和解冻，冻结时分配的节点数组在解冻后应被复用，占用的内存不随次数增长
+// 紧凑模式下每个节点数组独占节点池的一个16MB的块，若不复用，约4000次后块数达到上限
+template <typename Policy>
+void test_freeze_thaw() {
+	skip_set<int, std::less<int>, 0, Policy> iset;
+	for (int i = 0; i < 10; ++i) iset.insert(i);
+	iset.freeze();
+	iset.thaw();
+	size_t before = virtual_pages();
+	for (int round = 0; round < 5000; ++round) {
+		iset.freeze();
+		assert(iset.frozen() && *iset.lower_bound(5) == 5);
+		iset.thaw();
+		assert(!iset.frozen() && iset.size() == 10);
+	}
+	// 增长不超过64MB（按4KB的页计算）
+	assert(virtual_pages() <= before + (size_t(64) << 20) / 4096);
+	std::cout << "freeze/thaw 5000 times, size=" << iset.size() << std::endl;
+}
+
+// 被移动后的跳表成为空容器，查找、插入和迭代均可正常进行
+void test_moved_from() {
+	skip_set<int> iset;
+	for (int i = 0; i < 10; ++i) iset.insert(i);
+	skip_set<int> other(std::move(iset));
+	assert(other.size() == 10 && iset.empty());
+	assert(iset.begin() == iset.end() && iset.find(3) == iset.end());
+	iset.insert(3);
+	assert(iset.size() == 1 && *iset.begin() == 3 && iset.find(3) != iset.end());
+	// 移动赋值与rhs交换
+	other = std::move(iset);
+	assert(other.size() == 1 && iset.size() == 10 && iset.find(3) != iset.end());
+	// 被移动后的空跳表在第一次修改时才分配header，合并、拆分和冻结都可以直接进行
+	static_assert(std::is_nothrow_move_constructible<skip_set<int>>::value, "move constructor should be noexcept");
+	skip_set<int> a(std::move(iset)), b(std::move(a)), c(std::move(b));
+	a.merge(c);
+	assert(a.size() == 10 && c.empty());
+	assert(c.split(5).empty() && c.empty());
+	b = a.split(5);
+	assert(a.size() == 5 && b.size() == 5);
+	skip_set<int> d(std::move(b));
+	b.freeze();
+	b.insert(1);
+	b.join(d);
+	assert(b.size() == 6 && *b.begin() == 1 && d.empty());
+	c.swap(d);
+	c.clear();
+	c.insert(2);
+	assert(c.size() == 1);
+	std::cout << "moved-from size=" << iset.size() << std::endl;
+}
+
+// 检查skip_set与std::set中的元素相同
+template <typename Set>
+bool same_elements(const Set &s, const std::set<int> &ref) {
+	return s.size() == ref.size() && std::equal(ref.begin(), ref.end(), s.begin());
+}
+
+// 集合运算和合并，与std::set_union等算法的结果比较
+void test_set_algebra() {
+	skip_set<int> a, b;
+	std::set<int> ra, rb;
+	for (int i = 0; i < 300; ++i) {
+		a.insert(i * 2);
+		ra.insert(i * 2);
+		b.insert(i * 3);
+		rb.insert(i * 3);
+	}
+	std::set<int> expect;
+	std::set_union(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expect, expect.end()));
+	assert(same_elements(a.set_union(b), expect));
+	expect.clear();
+	std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expect, expect.end()));
+	assert(same_elements(a.set_intersection(b), expect));
+	expect.clear();
+	std::set_difference(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expect, expect.end()));
+	assert(same_elements(a.set_difference(b), expect));
+
+	// 合并后b中只剩key与a重复的元素
+	a.merge(b);
+	expect.clear();
+	std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expect, expect.end()));
+	assert(same_elements(b, expect));
+	ra.insert(rb.begin(), rb.end());
+	assert(same_elements(a, ra));
+	std::cout << "merge size=" << a.size() << std::endl;
+}
+
+// 在不同位置拆分后再连接，拆分的两部分和连接的结果都应与std::set一致
+void test_split_join() {
+	skip_set<int> iset;
+	std::set<int> ref;
+	for (int i = 0; i < 500; ++i) {
+		iset.insert(i * 7 % 1000);
+		ref.insert(i * 7 % 1000);
+	}
+	for (int k : {-1, 0, 350, 351, 998, 1000}) {
+		skip_set<int> high = iset.split(k);
+		assert(same_elements(iset, std::set<int>(ref.begin(), ref.lower_bound(k))));
+		assert(same_elements(high, std::set<int>(ref.lower_bound(k), ref.end())));
+		iset.join(high);
+		assert(high.empty() && same_elements(iset, ref));
+		// 拆分和连接后仍可正常插入和删除
+		iset.insert(k + 1000);
+		iset.erase(k + 1000);
+	}
+	assert(same_elements(iset, ref));
+	std::cout << "split/join size=" << iset.size() << std::endl;
+}
+
+// 摘除节点、修改key后重新插入，节点不被重新分配；插入失败时节点仍由句柄拥有
+void test_node_handle() {
+	skip_set<int> a, b;
+	for (int i = 0; i < 10; ++i) {
+		a.insert(i);
+		b.insert(i * 10);
+	}
+	skip_set<int>::node_type nh = a.extract(3);
+	assert(!nh.empty() && nh.value() == 3 && a.size() == 9 && a.find(3) == a.end());
+	assert(a.extract(3).empty());
+	const int *address = &nh.value();
+	nh.key() = 35;
+	skip_set<int>::insert_return_type r = b.insert(std::move(nh));
+	assert(r.inserted && r.node.empty() && *r.position == 35 && &*r.position == address);
+
+	// key已存在时插入失败
+	nh = a.extract(a.find(5));
+	nh.key() = 40;
+	r = b.insert(std::move(nh));
+	assert(!r.inserted && !r.node.empty() && *r.position == 40 && r.node.value() == 40);
+	assert(b.size() == 11 && a.size() == 8);
+	std::cout << "node handle size=" << b.size() << std::endl;
+}
+
+// 分批整理，两批之间插入和删除元素，整理过程中和整理完成后元素都应与std::set一致
+// 整理完成后按key遍历时节点的地址大多是递增的，紧凑模式下不同大小的节点同样按key的顺序连续存放
+template <typename Policy>
+void test_compact() {
+	skip_set<int, std::less<int>, 0, Policy> iset;
+	std::set<int> ref;
+	for (int i = 0; i < 2000; ++i) {
+		iset.insert(i * 7919 % 2003);
+		ref.insert(i * 7919 % 2003);
+	}
+	int batches = 0;
+	while (!iset.compact(100)) {
+		assert(same_elements(iset, ref));
+		iset.erase(batches * 13);
+		ref.erase(batches * 13);
+		iset.insert(3000 + batches);
+		ref.insert(3000 + batches);
+		++batches;
+	}
+	assert(batches > 0 && same_elements(iset, ref));
+	iset.compact();
+	size_t ascending = 0;
+	const int *prev = nullptr;
+	for (const int &x : iset) {
+		if (prev && prev < &x) ++ascending;
+		prev = &x;
+	}
+	assert(same_elements(iset, ref) && ascending * 10 >= iset.size() * 9);
+	// 紧凑模式下反复整理时，旧的节点所在的块全部释放后被复用，占用的内存不随次数增长（不超过64MB，按4KB的页计算）
+	// 默认模式下的内存段由系统分配器回收，不做检查
+	size_t before = virtual_pages();
+	for (int round = 0; round < 2000; ++round) iset.compact();
+	assert(same_elements(iset, ref));
+	if (std::is_same<Policy, skiplist_compact_policy>::value) assert(virtual_pages() <= before + (size_t(64) << 20) / 4096);
+	std::cout << "compact in " << batches + 1 << " batches, size=" << iset.size() << std::endl;
+}
+
+// 游标向递增的key反复定位，每次定位的结果都应与lower_bound相同；目标key后退时从头查找
+void test_cursor() {
+	skip_set<int> iset;
+	for (int i = 0; i < 1000; ++i) iset.insert(i * 3);
+	skip_set<int>::cursor c = iset.get_cursor();
+	assert(c.valid() && *c == 0);
+	for (int k = -5; k < 3010; k += 7) {
+		c.seek(k);
+		assert(c.position() == iset.lower_bound(k));
+		if (c.valid() && k % 2) {
+			c.next();
+			assert(!c.valid() || *c == *iset.lower_bound(k) + 3);
+		}
+	}
+	assert(!c.valid());
+	c.seek(100);
+	assert(c.valid() && *c == 102);
+	c.rewind();
+	assert(*c == 0);
+
+	// 冻结后游标通过冻结的索引定位
+	iset.freeze();
+	skip_set<int>::cursor f = iset.get_cursor();
+	for (int k = 0; k < 3000; k += 100) {
+		f.seek(k);
+		assert(f.valid() && *f == *iset.lower_bound(k));
+	}
+	iset.thaw();
+	std::cout << "cursor ok" << std::endl;
+}
+
+// 冻结后的查找、遍历和拷贝与冻结前一致，解冻后可继续修改
+template <typename Policy>
+void test_frozen_lookup() {
+	skip_set<long, std::less<long>, 0, Policy> iset;
+	std::set<int> ref;
+	for (int i = 0; i < 5000; ++i) {
+		iset.insert(i * 7919 % 10007);
+		ref.insert(i * 7919 % 10007);
+	}
+	iset.freeze();
+	assert(iset.frozen() && std::equal(ref.begin(), ref.end(), iset.begin()));
+	for (long k = -1; k < 10010; k += 3) {
+		std::set<int>::iterator r = ref.lower_bound(k);
+		assert((iset.find(k) != iset.end()) == (r != ref.end() && *r == k));
+		assert(r == ref.end() ? iset.lower_bound(k) == iset.end() : *iset.lower_bound(k) == *r);
+	}
+	skip_set<long, std::less<long>, 0, Policy> copy(iset);
+	assert(copy.frozen() && copy == iset);
+	iset.thaw();
+	iset.insert(-5);
+	iset.erase(*ref.begin());
+	assert(iset.size() == ref.size() && *iset.begin() == -5);
+	std::cout << "frozen lookup ok, size=" << iset.size() << std::endl;
+}
+
+// 冻结后的修改操作先自动解冻，结果与std::set一致；以已存在的key插入不会解冻
+template <typename Policy>
+void test_frozen_write() {
+	typedef skip_set<long, std::less<long>, 0, Policy> set_type;
+	set_type iset;
+	std::set<int> ref;
+	for (int i = 0; i < 1000; ++i) {
+		iset.insert(i);
+		ref.insert(i);
+	}
+	iset.freeze();
+	assert(!iset.insert(500).second && iset.frozen());
+	assert(iset.compact() && iset.frozen());
+	iset.erase(*iset.find(500));
+	ref.erase(500);
+	assert(!iset.frozen() && same_elements(iset, ref));
+
+	iset.freeze();
+	iset.insert(5000);
+	ref.insert(5000);
+	iset.freeze();
+	iset.pop_front();
+	ref.erase(ref.begin());
+	iset.freeze();
+	iset.erase(iset.find(100), iset.find(200));
+	ref.erase(ref.find(100), ref.find(200));
+	iset.freeze();
+	typename set_type::node_type nh = iset.extract(*iset.find(300));
+	ref.erase(300);
+	assert(!iset.frozen() && same_elements(iset, ref));
+	iset.freeze();
+	nh.key() = -1;
+	assert(iset.insert(std::move(nh)).inserted);
+	ref.insert(-1);
+
+	// 合并、拆分和连接时两侧都可能已冻结
+	set_type other;
+	other.insert(7000);
+	ref.insert(7000);
+	iset.freeze();
+	other.freeze();
+	iset.merge(other);
+	assert(other.empty() && same_elements(iset, ref));
+	iset.freeze();
+	set_type high = iset.split(*iset.find(600));
+	iset.freeze();
+	high.freeze();
+	iset.join(high);
+	assert(high.empty() && same_elements(iset, ref));
+	std::cout << "frozen write ok, size=" << iset.size() << std::endl;
+}
+
+// 每次操作都采样的观察者，用于统计查找的步数
+struct traced_every_op_policy : skiplist_default_policy {
+	typedef skiplist_latency_observer<0> observer;
+};
+
+// 并行建表前按最终的节点数量提高层数上限，即使初始的层数上限很低，查找的平均步数也为O(log n)
+void test_parallel_level() {
+	std::vector<int> keys(1 << 16);
+	for (int i = 0; i < int(keys.size()); ++i) keys[i] = i * 7919 % int(keys.size());
+	skip_set<int, std::less<int>, 0, traced_every_op_policy> iset(keys.begin(), keys.end(), 2, std::less<int>(), skiplist_parallel(4));
+	assert(iset.size() == keys.size());
+	for (int i = 0; i < 1000; ++i) assert(iset.find(i * 61) != iset.end());
+	uint64_t hops = 0;
+	for (size_t level = 0; level < skiplist_latency_observer<0>::max_levels; ++level) hops += iset.get_observer().hops(level);
+	uint64_t finds = iset.get_observer().count(skiplist_op_find);
+	assert(finds == 1000 && hops / finds < 100);
+	std::cout << "parallel build hops per find=" << hops / finds << std::endl;
+}
+
+// 紧凑模式下与确定性平衡和自适应平衡组合的策略，节点的层级提升时forward数组被重新分配到节点之外
+struct compact_deterministic_policy : skiplist_compact_policy {
+	static const skiplist_balance balance = skiplist_deterministic_balance;
+};
+struct compact_adaptive_policy : skiplist_compact_policy {
+	static const skiplist_balance balance = skiplist_adaptive_balance;
+};
+
+// 紧凑模式下节点不保存forward数组的地址，重新分配到节点池中的forward数组（包括随节点数量增长的header）应被正确地找到和释放
+template <typename Policy>
+void test_compact_links() {
+	skip_set<int, std::less<int>, 0, Policy> iset(1);
+	std::set<int> ref;
+	for (int i = 0; i < 20000; ++i) {
+		int k = i * 7919 % 10007;
+		if (i % 3 == 2) {
+			iset.erase(k);
+			ref.erase(k);
+		} else {
+			iset.insert(k);
+			ref.insert(k);
+		}
+		if (i % 5 == 0) assert((iset.find(k) != iset.end()) == (ref.find(k) != ref.end()));
+	}
+	assert(same_elements(iset, ref));
+	skip_set<int, std::less<int>, 0, Policy> upper = iset.split(5000);
+	iset.join(upper);
+	assert(same_elements(iset, ref) && upper.empty());
+	std::cout << "compact links ok, size=" << iset.size() << std::endl;
+}
+
+// 冻结索引按块计数时使用的__simd_count_less，与逐个比较的结果相同，包括有符号数的负值和无符号数的最高位
+// 以-msse4.2或-mavx2编译时检查的是SIMD实现，否则为标量实现
+template <typename Key>
+void test_count_less() {
+	std::vector<Key> keys;
+	keys.push_back(std::numeric_limits<Key>::min());
+	keys.push_back(std::numeric_limits<Key>::max());
+	for (int i = 0; i < 38; ++i) keys.push_back(Key((i - 19) * 1000003LL * (i % 3 ? 1 : 4611686018LL)));
+	for (size_t n = 0; n <= keys.size(); ++n) {
+		for (const Key &k : keys) {
+			size_t expect = std::count_if(keys.begin(), keys.begin() + n, [&k](const Key &x) { return x < k; });
+			assert(__simd_count_less(keys.data(), n, k) == expect);
+		}
+	}
+}
+
+void test_simd() {
+	test_count_less<int32_t>();
+	test_count_less<uint32_t>();
+	test_count_less<int64_t>();
+	test_count_less<uint64_t>();
+#if defined(__AVX2__)
+	std::cout << "count_less ok (avx2)" << std::endl;
+#elif defined(__SSE4_2__)
+	std::cout << "count_less ok (sse4.2)" << std::endl;
+#else
+	std::cout << "count_less ok (scalar)" << std::endl;
+#endif
+}
+
+// 随机插入、删除和查找，每一步都与std::set比较，每次查找后调用check(s, k)检查各策略额外的性质
+template <typename Set, typename Check>
+void random_ops(Set &s, std::set<int> &ref, int range, int rounds, Check check) {
+	srand(range + rounds);
+	for (int round = 0; round < rounds; ++round) {
+		int k = rand() % range;
+		switch (rand() % 3) {
+			case 0: assert(s.insert(k).second == ref.insert(k).second); break;
+			case 1: s.erase(k); ref.erase(k); break;
+			case 2:
+				assert((s.find(k) != s.end()) == (ref.find(k) != ref.end()));
+				check(s, k);
+				break;
+		}
+	}
+	assert(same_elements(s, ref));
+}
+
+// 记录每次查找路径的确定性平衡策略
+struct traced_deterministic_policy : skiplist_deterministic_policy {
+	typedef skiplist_latency_observer<0> observer;
+};
+
+// 确定性平衡模式下每层的间隔只有1~3个节点，因此任何一次查找在每层最多前进3步
+// 插入、删除以及合并、拆分和连接之后都应保持这一性质
+void test_deterministic() {
+	typedef skip_set<int, std::less<int>, 0, traced_deterministic_policy> dset;
+	auto bounded = [](const dset &s, int k) {
+		s.get_observer().reset();
+		s.find(k);
+		for (size_t level = 0; level < skiplist_latency_observer<0>::max_levels; ++level) assert(s.get_observer().hops(level) <= 3);
+	};
+	for (int range : {10, 1000, 100000}) {
+		dset iset;
+		std::set<int> ref;
+		random_ops(iset, ref, range, 20000, bounded);
+		// 拆分后两部分分别修改，再合并回来
+		dset upper = iset.split(range / 2);
+		std::set<int> upper_ref(ref.lower_bound(range / 2), ref.end());
+		ref.erase(ref.lower_bound(range / 2), ref.end());
+		assert(same_elements(iset, ref) && same_elements(upper, upper_ref));
+		random_ops(upper, upper_ref, range, 2000, bounded);
+		iset.merge(upper);
+		ref.insert(upper_ref.begin(), upper_ref.end());
+		random_ops(iset, ref, range, 2000, bounded);
+		// 拆分后立即连接
+		dset tail = iset.split(range / 3);
+		iset.join(tail);
+		assert(tail.empty());
+		random_ops(iset, ref, range, 2000, bounded);
+		std::cout << "deterministic range=" << range << " size=" << iset.size() << std::endl;
+	}
+}
+
+// 统计比较次数的比较函数，用于衡量查找路径的长度
+struct counting_less {
+	static size_t calls;
+	bool operator()(int a, int b) const { ++calls; return a < b; }
+};
+size_t counting_less::calls = 0;
+
+// 对keys中的每个key调用find，返回平均每次查找的比较次数
+template <typename Set>
+double compares_per_lookup(const Set &s, const std::vector<int> &keys) {
+	counting_less::calls = 0;
+	for (int k : keys) assert(*s.find(k) == k);
+	return double(counting_less::calls) / keys.size();
+}
+
+// 自适应平衡模式下反复查找的热点key被提升，查找路径短于其他key
+// 热点转移后新的热点key被提升，原来的热点key冷却后被降级；层级调整过程中元素始终与std::set一致
+void test_adaptive() {
+	typedef skip_set<int, counting_less, 0, skiplist_adaptive_policy> aset;
+	aset iset;
+	std::set<int> ref;
+	for (int i = 0; i < 10000; ++i) {
+		iset.insert(i);
+		ref.insert(i);
+	}
+	std::vector<int> hot, next_hot;
+	for (int i = 0; i < 16; ++i) {
+		hot.push_back(i * 613 % 10000);
+		next_hot.push_back(i * 613 % 10000 + 3);
+	}
+	double cold = compares_per_lookup(iset, hot);
+	for (int round = 0; round < 2000; ++round)
+		for (int k : hot) iset.find(k);
+	double promoted = compares_per_lookup(iset, hot);
+	assert(promoted < cold && promoted < compares_per_lookup(iset, next_hot));
+
+	for (int round = 0; round < 100000; ++round)
+		for (int k : next_hot) iset.find(k);
+	assert(compares_per_lookup(iset, next_hot) < compares_per_lookup(iset, hot));
+	assert(compares_per_lookup(iset, hot) > promoted);
+
+	std::set<int> elems(iset.begin(), iset.end());
+	assert(elems == ref);
+	std::cout << "adaptive compares per lookup: cold=" << cold << " hot=" << promoted << std::endl;
+}
+
+// 维护哈希索引时，插入、删除、摘除后修改key重新插入，以及拆分、合并和清空之后，按key的查找都与std::set一致
+void test_hash_index() {
+	typedef skip_set<int, std::less<int>, 0, skiplist_hash_index_policy> hset;
+	hset iset;
+	std::set<int> ref;
+	auto ordered = [&ref](const hset &s, int k) {
+		std::set<int>::iterator r = ref.lower_bound(k);
+		assert(r == ref.end() ? s.lower_bound(k) == s.end() : *s.lower_bound(k) == *r);
+	};
+	random_ops(iset, ref, 1000, 20000, ordered);
+
+	srand(38);
+	for (int round = 0; round < 5000; ++round) {
+		int k = rand() % 1000, to = rand() % 1000;
+		hset::node_type nh = iset.extract(k);
+		assert(nh.empty() == !ref.erase(k));
+		assert(iset.find(k) == iset.end());
+		if (nh.empty()) continue;
+		nh.key() = to;
+		hset::insert_return_type r = iset.insert(std::move(nh));
+		assert(r.inserted == ref.insert(to).second && *r.position == to && iset.find(to) == r.position);
+	}
+	assert(same_elements(iset, ref));
+
+	hset upper = iset.split(500);
+	for (int k = 0; k < 1000; ++k) {
+		assert((iset.find(k) != iset.end()) == (k < 500 && ref.count(k)));
+		assert((upper.find(k) != upper.end()) == (k >= 500 && ref.count(k)));
+	}
+	iset.merge(upper);
+	for (int k = 0; k < 1000; ++k) assert((iset.find(k) != iset.end()) == bool(ref.count(k)));
+	random_ops(iset, ref, 1000, 5000, ordered);
+	iset.clear();
+	for (int k = 0; k < 1000; ++k) assert(iset.find(k) == iset.end());
+	std::cout << "hash index ok" << std::endl;
+}
+
+// 层数上限随节点数量增长，初始上限为2时逐个插入的跳表，查找的平均步数也为O(log n)，删除元素后仍与std::set一致
+void test_level_growth() {
+	typedef skip_set<int, std::less<int>, 0, traced_every_op_policy> tset;
+	const int n = 1 << 16;
+	tset iset(2);
+	std::set<int> ref;
+	for (int i = 0; i < n; ++i) {
+		iset.insert(i * 7919 % n);
+		ref.insert(i * 7919 % n);
+	}
+	iset.get_observer().reset();
+	for (int i = 0; i < 1000; ++i) assert(iset.find(i * 61) != iset.end());
+	uint64_t hops = 0;
+	for (size_t level = 0; level < skiplist_latency_observer<0>::max_levels; ++level) hops += iset.get_observer().hops(level);
+	assert(hops / 1000 < 100);
+	random_ops(iset, ref, n, 50000, [](const tset&, int) {});
+	std::cout << "level growth hops per find=" << hops / 1000 << std::endl;
+}
+
+// 缓存后继key并使用确定性平衡的策略，节点的层级在插入和删除时都会调整
+struct cached_deterministic_policy : skiplist_cached_links_policy {
+	static const skiplist_balance balance = skiplist_deterministic_balance;
+};
+
+// 缓存后继key时，插入、删除、拆分、合并和连接都会更新前驱节点中缓存的key，find和lower_bound与std::set一致
+template <typename Policy>
+void test_cached_links() {
+	typedef skip_set<int, std::less<int>, 0, Policy> cset;
+	cset iset;
+	std::set<int> ref;
+	auto ordered = [&ref](const cset &s, int k) {
+		std::set<int>::iterator r = ref.lower_bound(k);
+		assert(r == ref.end() ? s.lower_bound(k) == s.end() : *s.lower_bound(k) == *r);
+	};
+	random_ops(iset, ref, 5000, 30000, ordered);
+
+	cset upper = iset.split(2500);
+	std::set<int> upper_ref(ref.lower_bound(2500), ref.end());
+	ref.erase(ref.lower_bound(2500), ref.end());
+	random_ops(iset, ref, 2500, 5000, ordered);
+	iset.join(upper);
+	ref.insert(upper_ref.begin(), upper_ref.end());
+	random_ops(iset, ref, 5000, 5000, ordered);
+
+	cset other;
+	for (int i = 0; i < 5000; i += 3) other.insert(i);
+	iset.merge(other);
+	for (int i = 0; i < 5000; i += 3) ref.insert(i);
+	random_ops(iset, ref, 5000, 5000, ordered);
+	std::cout << "cached links size=" << iset.size() << std::endl;
+}
+
+// 每次操作都采样时，观察者记录的各操作次数与实际调用的次数相同，插入失败、删除和查找不存在的key也被记录
+void test_observer() {
+	typedef skip_set<int, std::less<int>, 0, traced_every_op_policy> tset;
+	tset iset;
+	std::set<int> ref;
+	uint64_t counts[skiplist_op_count] = {0};
+	srand(41);
+	for (int round = 0; round < 20000; ++round) {
+		int k = rand() % 1000;
+		switch (rand() % 3) {
+			case 0: assert(iset.insert(k).second == ref.insert(k).second); ++counts[skiplist_op_insert]; break;
+			case 1: iset.erase(k); ref.erase(k); ++counts[skiplist_op_erase]; break;
+			case 2: assert((iset.find(k) != iset.end()) == bool(ref.count(k))); ++counts[skiplist_op_find]; break;
+		}
+	}
+	assert(same_elements(iset, ref));
+	const skiplist_latency_observer<0> &observer = iset.get_observer();
+	for (int op = 0; op < skiplist_op_count; ++op) {
+		assert(observer.count(skiplist_op(op)) == counts[op]);
+		assert(observer.percentile(skiplist_op(op), 0.5) <= observer.percentile(skiplist_op(op), 1.0));
+	}
+	uint64_t hops = 0;
+	for (size_t level = 0; level < skiplist_latency_observer<0>::max_levels; ++level) hops += observer.hops(level);
+	assert(hops > 0);
+
+	// 统计信息不随复制转移
+	tset copy(iset);
+	assert(copy.get_observer().count(skiplist_op_find) == 0 && same_elements(copy, ref));
+	iset.get_observer().reset();
+	for (int op = 0; op < skiplist_op_count; ++op) assert(observer.count(skiplist_op(op)) == 0);
+	std::cout << "observer finds=" << counts[skiplist_op_find] << std::endl;
+}
+
+// 批量查找的结果与逐个查找和std::set相同，包括不存在的key、重复的key、空批次以及冻结之后
+template <typename Policy>
+void test_find_many() {
+	typedef skip_set<int, std::less<int>, 0, Policy> set_type;
+	set_type iset;
+	std::set<int> ref;
+	random_ops(iset, ref, 2000, 5000, [](const set_type&, int) {});
+	std::vector<int> keys;
+	for (int i = 0; i < 1000; ++i) keys.push_back(rand() % 2200 - 100);
+	keys.push_back(keys.front());
+	std::vector<typename set_type::iterator> result(keys.size());
+	for (int pass = 0; pass < 2; ++pass) {
+		iset.find_many(keys.begin(), keys.end(), result.begin());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			assert(result[i] == iset.find(keys[i]));
+			assert(ref.count(keys[i]) ? *result[i] == keys[i] : result[i] == iset.end());
+		}
+		iset.find_many(keys.begin(), keys.begin(), result.begin());
+		iset.freeze();
+	}
+	std::cout << "find_many ok" << std::endl;
+}
+
+// 生成具有相同前缀、长度不同、可能含有'\0'字节的string key
+static std::string prefixed_key() {
+	static const char *prefixes[] = {"", "a", "user:", "user:000", "user:00000000/"};
+	std::string s = prefixes[rand() % 5] + std::to_string(rand() % 500);
+	if (rand() % 8 == 0) s.push_back('\0');
+	if (rand() % 8 == 0) s += std::string(rand() % 32, 'x');
+	return s;
+}
+
+// 节点内联string key的前缀和字节，大量key的前缀相同时，插入、删除、查找、lower_bound以及修改key后重新插入节点都与std::set一致
+void test_string_keys() {
+	typedef skip_set<std::string> sset;
+	sset strs;
+	std::set<std::string> ref;
+	srand(28);
+	for (int round = 0; round < 30000; ++round) {
+		std::string k = prefixed_key();
+		switch (rand() % 4) {
+			case 0: assert(strs.insert(k).second == ref.insert(k).second); break;
+			case 1: strs.erase(k); ref.erase(k); break;
+			case 2: {
+				assert((strs.find(k) != strs.end()) == bool(ref.count(k)));
+				std::set<std::string>::iterator r = ref.lower_bound(k);
+				assert(r == ref.end() ? strs.lower_bound(k) == strs.end() : *strs.lower_bound(k) == *r);
+				break;
+			}
+			case 3: {
+				// 修改后的key可能更长，所需的内联字节超出原节点时重新分配节点
+				sset::node_type nh = strs.extract(k);
+				assert(nh.empty() == !ref.erase(k));
+				if (nh.empty()) break;
+				std::string to = prefixed_key();
+				nh.key() = to;
+				sset::insert_return_type r = strs.insert(std::move(nh));
+				assert(r.inserted == ref.insert(to).second && *r.position == to);
+				break;
+			}
+		}
+	}
+	assert(strs.size() == ref.size() && std::equal(ref.begin(), ref.end(), strs.begin()));
+	std::cout << "string keys size=" << strs.size() << std::endl;
+}
+
+// 并行建表和向非空容器并行插入无序且有重复的key，结果与std::set一致，之后仍可正常修改
+template <typename Policy>
+void test_parallel_build() {
+	typedef skip_set<int, std::less<int>, 0, Policy> set_type;
+	srand(31);
+	std::vector<int> keys, more;
+	for (int i = 0; i < 100000; ++i) keys.push_back(rand() % 60000);
+	for (int i = 0; i < 50000; ++i) more.push_back(rand() % 120000);
+	for (size_t threads : {1, 2, 4}) {
+		set_type iset(keys.begin(), keys.end(), skiplist_parallel(threads));
+		std::set<int> ref(keys.begin(), keys.end());
+		assert(same_elements(iset, ref));
+		iset.insert(more.begin(), more.end(), skiplist_parallel(threads));
+		ref.insert(more.begin(), more.end());
+		assert(same_elements(iset, ref));
+		random_ops(iset, ref, 120000, 20000, [](const set_type&, int) {});
+	}
+	std::cout << "parallel build ok" << std::endl;
+}
+
+// 并行遍历和并行归约的结果与在std::set上顺序计算的结果相同，包括空区间、lo大于hi以及超出key范围的区间，冻结后亦然
+void test_parallel_scan() {
+	skip_set<int> iset;
+	std::set<int> ref;
+	random_ops(iset, ref, 100000, 100000, [](const skip_set<int>&, int) {});
+	srand(32);
+	for (int pass = 0; pass < 2; ++pass) {
+		for (int round = 0; round < 100; ++round) {
+			int lo = rand() % 110000 - 5000, hi = rand() % 110000 - 5000;
+			long long expect = 0, count = 0;
+			for (std::set<int>::iterator it = ref.lower_bound(lo); it != ref.end() && *it < hi; ++it, ++count) expect += *it;
+			size_t threads = 1 + round % 4;
+			assert(iset.parallel_reduce(lo, hi, 0LL, std::plus<long long>(), skiplist_parallel(threads)) == expect);
+			std::atomic<long long> visited(0), sum(0);
+			iset.parallel_for_each(lo, hi, [&](int x) {
+				assert(lo <= x && x < hi);
+				++visited;
+				sum += x;
+			}, skiplist_parallel(threads));
+			assert(visited == count && sum == expect);
+		}
+		iset.freeze();
+	}
+	std::cout << "parallel scan ok" << std::endl;
+}
+
 // 测试skip_set的例子，取自《STL源码剖析》第236页
 int main() {
-	int i;
 	int ia[5] = {0, 1, 2, 3, 4};
 	skip_set<int> iset(ia, ia+5);
 
@@ -36,5 +747,42 @@ int main() {
 	ite1 = iset.find(1);
 	std::cout << 1 << (ite1 != iset.end() ? " found" : " not found") << std::endl;
 
+	test_freeze_thaw<skiplist_default_policy>();
+	test_freeze_thaw<skiplist_compact_policy>();
+	test_moved_from();
+	test_set_algebra();
+	test_split_join();
+	test_node_handle();
+	test_compact<skiplist_default_policy>();
+	test_compact<skiplist_compact_policy>();
+	test_cursor();
+	test_frozen_lookup<skiplist_default_policy>();
+	test_frozen_lookup<skiplist_compact_policy>();
+	test_frozen_write<skiplist_default_policy>();
+	test_frozen_write<skiplist_deterministic_policy>();
+	test_frozen_write<skiplist_hash_index_policy>();
+	test_frozen_write<skiplist_compact_policy>();
+	test_parallel_level();
+	test_compact_links<skiplist_compact_policy>();
+	test_compact_links<compact_deterministic_policy>();
+	test_compact_links<compact_adaptive_policy>();
+	test_simd();
+	test_deterministic();
+	test_adaptive();
+	test_hash_index();
+	test_level_growth();
+	test_cached_links<skiplist_cached_links_policy>();
+	test_cached_links<cached_deterministic_policy>();
+	test_observer();
+	test_find_many<skiplist_default_policy>();
+	test_find_many<skiplist_hash_index_policy>();
+	test_find_many<skiplist_cached_links_policy>();
+	test_find_many<skiplist_compact_policy>();
+	test_string_keys();
+	test_parallel_build<skiplist_default_policy>();
+	test_parallel_build<skiplist_deterministic_policy>();
+	test_parallel_build<skiplist_compact_policy>();
+	test_parallel_scan();
+
 	return 0;
 }
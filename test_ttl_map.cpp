@@ -0,0 +1,80 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "include/skip_ttl_map.h"
+
+// 由测试手动推进的时钟，使过期时刻可以精确控制
+struct fake_clock {
+	typedef std::chrono::seconds duration;
+	typedef duration::rep rep;
+	typedef duration::period period;
+	typedef std::chrono::time_point<fake_clock> time_point;
+	static const bool is_steady = true;
+	static rep ticks;
+	static time_point now() { return time_point(duration(ticks)); }
+	static void advance(rep seconds) { ticks += seconds; }
+};
+fake_clock::rep fake_clock::ticks = 0;
+
+typedef skip_ttl_map<std::string, int, std::less<std::string>, 0, skiplist_default_policy, fake_clock> ttl_map;
+
+static int live_count(const ttl_map &m) {
+	int n = 0;
+	for (ttl_map::iterator it = m.begin(); it != m.end(); ++it) ++n;
+	return n;
+}
+
+// 测试skip_ttl_map的例子，通过推进时钟检查元素按时过期、被reap回收，以及续期和取消过期
+int main() {
+	ttl_map sessions;
+	sessions.insert(std::make_pair(std::string("alice"), 1), std::chrono::seconds(10));
+	sessions.insert(std::make_pair(std::string("bob"), 2), std::chrono::seconds(20));
+	sessions.insert(std::make_pair(std::string("carol"), 3));
+	sessions[std::string("dave")] = 4;
+	assert(sessions.size() == 4 && sessions.expiring() == 2 && live_count(sessions) == 4);
+
+	// 过期时间不晚于当前时刻即视为过期
+	fake_clock::advance(9);
+	assert(sessions.count(std::string("alice")) == 1);
+	fake_clock::advance(1);
+	assert(sessions.find(std::string("alice")) == sessions.end());
+	assert(sessions.lower_bound(std::string("a")).key() == "bob");
+	assert(live_count(sessions) == 3 && sessions.size() == 4);
+	std::cout << "t=10 live=" << live_count(sessions) << " size=" << sessions.size() << std::endl;
+
+	// 续期bob后取消其过期时间，已过期的alice不能续期
+	assert(sessions.expire(std::string("bob"), std::chrono::seconds(100)));
+	assert(!sessions.expire(std::string("alice"), std::chrono::seconds(100)));
+	fake_clock::advance(50);
+	assert(sessions.find(std::string("bob")) != sessions.end());
+	assert(sessions.persist(std::string("bob")) && sessions.expiring() == 1);
+
+	// 已过期的key被视为不存在，插入时作为新元素
+	std::pair<ttl_map::iterator, bool> r = sessions.insert(std::make_pair(std::string("alice"), 5), std::chrono::seconds(5));
+	assert(r.second && r.first.value() == 5);
+	r = sessions.insert(std::make_pair(std::string("alice"), 6));
+	assert(!r.second && r.first.value() == 5);
+
+	// reap只删除已过期的元素
+	for (int i = 0; i < 100; ++i) sessions.insert(std::make_pair("user" + std::to_string(i), i), std::chrono::seconds(1 + i % 10));
+	fake_clock::advance(5);
+	sessions.reap(1000);
+	assert(sessions.find(std::string("alice")) == sessions.end() && sessions.size() == size_t(live_count(sessions)));
+	fake_clock::advance(10);
+	sessions.reap(1000);
+	assert(sessions.size() == 3 && sessions.expiring() == 0);
+	std::cout << "t=" << fake_clock::ticks << " size=" << sessions.size() << std::endl;
+
+	for (ttl_map::iterator it = sessions.begin(); it != sessions.end(); ++it)
+		std::cout << it.key() << " " << it.value() << std::endl;
+
+	// 被移动后的容器为空且可继续使用
+	ttl_map moved(std::move(sessions));
+	assert(moved.size() == 3 && sessions.begin() == sessions.end());
+	sessions.insert(std::make_pair(std::string("erin"), 7), std::chrono::seconds(1));
+	fake_clock::advance(1);
+	assert(sessions.reap() == 1 && sessions.empty());
+
+	return 0;
+}
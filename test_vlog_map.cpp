@@ -0,0 +1,74 @@
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include "include/skip_vlog_map.h"
+
+// 实值为1KB的数组，每个元素都由key和版本号决定，用于检查回收后实值是否完整
+typedef std::array<int, 256> blob;
+
+static blob make_blob(int key, int version) {
+	blob b;
+	for (size_t i = 0; i < b.size(); ++i) b[i] = key * 31 + version + int(i);
+	return b;
+}
+
+// 逐个比较skip_vlog_map与记录了版本号的std::map中的元素
+static void check_same(const skip_vlog_map<int, blob> &m, const std::map<int, int> &ref) {
+	assert(m.size() == ref.size());
+	skip_vlog_map<int, blob>::iterator it = m.begin();
+	for (std::map<int, int>::const_iterator x = ref.begin(); x != ref.end(); ++x, ++it) {
+		assert(it != m.end() && it.key() == x->first && it.value() == make_blob(x->first, x->second));
+	}
+	assert(it == m.end());
+}
+
+// 测试skip_vlog_map的例子，覆盖和删除元素后回收垃圾，存活的实值应保持不变
+int main() {
+	skip_vlog_map<int, blob> vmap;
+	std::map<int, int> ref;
+	for (int i = 0; i < 3000; ++i) {
+		vmap.insert(std::make_pair(i, make_blob(i, 0)));
+		ref[i] = 0;
+	}
+	// 覆盖偶数key，删除key为3的倍数的元素，使日志中的大部分记录成为垃圾
+	for (int i = 0; i < 3000; i += 2) {
+		vmap.insert_or_assign(i, make_blob(i, 1));
+		ref[i] = 1;
+	}
+	for (int i = 0; i < 3000; i += 3) {
+		vmap.erase(i);
+		ref.erase(i);
+	}
+	check_same(vmap, ref);
+	std::cout << "size=" << vmap.size() << " log=" << vmap.log_bytes() << " garbage=" << vmap.garbage_bytes() << std::endl;
+
+	// 回收后垃圾减少，通过迭代器和find读到的实值不变
+	size_t garbage = vmap.garbage_bytes();
+	assert(vmap.collect(1.0) > 0);
+	assert(vmap.garbage_bytes() < garbage);
+	check_same(vmap, ref);
+	assert(vmap.find(1).value() == make_blob(1, 0) && vmap.find(3) == vmap.end());
+	std::cout << "after collect: log=" << vmap.log_bytes() << " garbage=" << vmap.garbage_bytes() << std::endl;
+
+	// 通过operator[]修改日志中的实值后再次回收
+	for (int i = 1; i < 3000; i += 2) {
+		if (!ref.count(i)) continue;
+		vmap[i] = make_blob(i, 2);
+		ref[i] = 2;
+	}
+	vmap.collect(1.0);
+	check_same(vmap, ref);
+
+	// 拷贝和移动，被移动后的容器为空且可继续使用
+	skip_vlog_map<int, blob> copy(vmap);
+	check_same(copy, ref);
+	skip_vlog_map<int, blob> moved(std::move(copy));
+	check_same(moved, ref);
+	assert(copy.begin() == copy.end() && copy.find(1) == copy.end());
+	copy.insert(std::make_pair(7, make_blob(7, 0)));
+	assert(copy.size() == 1 && copy.find(7).value() == make_blob(7, 0));
+	std::cout << "collect ok, size=" << moved.size() << std::endl;
+
+	return 0;
+}